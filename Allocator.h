@@ -0,0 +1,443 @@
+// ---------------------------
+// projects/matlab/Allocator.h
+// Copyright (C) 2012
+// Glenn P. Downing
+// ---------------------------
+
+#ifndef Allocator_h
+#define Allocator_h
+
+// --------
+// includes
+// --------
+
+#include <cstddef>  // ptrdiff_t, size_t
+#include <cstdlib>  // calloc, free, malloc
+#include <iterator> // random_access_iterator_tag
+#include <new>      // bad_alloc
+
+#if __cplusplus >= 201103L
+#include <type_traits> // true_type
+#include <utility>     // forward
+#endif
+
+#ifdef __linux__
+#include <sys/mman.h>    // MAP_ANONYMOUS, MAP_FAILED, MAP_PRIVATE, mmap, munmap, PROT_READ, PROT_WRITE
+#include <sys/syscall.h> // SYS_mbind
+#include <unistd.h>      // _SC_PAGESIZE, syscall, sysconf
+#endif
+
+/**
+ * Matrices of at least this many bytes in all are placed by NumaPolicy; smaller
+ * ones are left to first touch.
+ */
+#ifndef MATRIX_NUMA_THRESHOLD
+#define MATRIX_NUMA_THRESHOLD (std::size_t(1) << 20)
+#endif
+
+// ------------
+// calloc_zero
+// ------------
+
+/**
+ * Whether a T whose bytes are all zero is a valid T equal to T(), so that memory
+ * from calloc needs no further initialization. True for the arithmetic types.
+ */
+template <typename T>
+struct calloc_zero {
+    static const bool value = false;};
+
+#define MATRIX_CALLOC_ZERO(T)           \
+    template <>                         \
+    struct calloc_zero<T> {             \
+        static const bool value = true;};
+
+MATRIX_CALLOC_ZERO(bool)
+MATRIX_CALLOC_ZERO(char)
+MATRIX_CALLOC_ZERO(signed char)
+MATRIX_CALLOC_ZERO(unsigned char)
+MATRIX_CALLOC_ZERO(short)
+MATRIX_CALLOC_ZERO(unsigned short)
+MATRIX_CALLOC_ZERO(int)
+MATRIX_CALLOC_ZERO(unsigned int)
+MATRIX_CALLOC_ZERO(long)
+MATRIX_CALLOC_ZERO(unsigned long)
+MATRIX_CALLOC_ZERO(float)
+MATRIX_CALLOC_ZERO(double)
+MATRIX_CALLOC_ZERO(long double)
+
+// -------------
+// zero_iterator
+// -------------
+
+/**
+ * What a zero_iterator points to: the request to construct an element of a block
+ * just allocated by a zeroed matrix_allocator, which is already zero.
+ */
+struct zero_fill {
+    /**
+     * For vector<bool>, which copies the range into its bits instead.
+     */
+    operator bool () const {
+        return false;}};
+
+/**
+ * The positions of a range of n zero_fills, to build a row of n zeros with the
+ * range constructor of vector: that allocates a fresh block and constructs each
+ * element from a zero_fill, which a zeroed matrix_allocator leaves to calloc for
+ * calloc_zero types. Any other construction value-initializes as usual.
+ */
+class zero_iterator {
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef zero_fill                       value_type;
+        typedef std::ptrdiff_t                  difference_type;
+        typedef const zero_fill*                pointer;
+        typedef const zero_fill&                reference;
+
+    private:
+        std::size_t _i;
+
+    public:
+        explicit zero_iterator (std::size_t i) :
+                _i(i) {}
+
+        reference operator * () const {
+            static const zero_fill z = zero_fill();
+            return z;}
+
+        zero_iterator& operator ++ () {
+            ++_i;
+            return *this;}
+
+        zero_iterator operator ++ (int) {
+            zero_iterator x = *this;
+            ++_i;
+            return x;}
+
+        zero_iterator& operator -- () {
+            --_i;
+            return *this;}
+
+        zero_iterator& operator += (difference_type n) {
+            _i += n;
+            return *this;}
+
+        friend difference_type operator - (const zero_iterator& lhs, const zero_iterator& rhs) {
+            return static_cast<difference_type>(lhs._i - rhs._i);}
+
+        friend bool operator == (const zero_iterator& lhs, const zero_iterator& rhs) {
+            return lhs._i == rhs._i;}
+
+        friend bool operator != (const zero_iterator& lhs, const zero_iterator& rhs) {
+            return lhs._i != rhs._i;}
+
+        friend bool operator < (const zero_iterator& lhs, const zero_iterator& rhs) {
+            return lhs._i < rhs._i;}};
+
+// --------------
+// numa_placement
+// --------------
+
+enum numa_placement {
+    numa_first_touch, // each page lands on the node of the thread that first writes it
+    numa_interleave,  // pages are spread round robin across all the nodes
+    numa_bind};       // pages are kept on NumaPolicy::node()
+
+// ----------
+// NumaPolicy
+// ----------
+
+/**
+ * Where the rows of a Matrix live on a NUMA machine.
+ *
+ * There is no scheduler of its own: every parallel row loop of Matrix and Matlab,
+ * construction included, is schedule(static) over the rows, so all of them split
+ * the rows into the same blocks. With a fixed number of threads pinned to their
+ * cores (OMP_PROC_BIND=close or spread, OMP_DYNAMIC=false), row block t is first
+ * touched by thread t, and so lives on its node, and is then worked on by thread t
+ * again. A loop run with another number of threads, or a row loop of your own with
+ * another schedule, works on rows that live elsewhere.
+ * That is the default, numa_first_touch, and rows come from malloc. numa_interleave
+ * spreads the pages of a matrix across the nodes instead, for data shared by every
+ * thread; numa_bind keeps them on one node. Either applies to the matrices of at least
+ * MATRIX_NUMA_THRESHOLD bytes made after the change, whose rows of a page or more are
+ * then mapped from the OS, each on pages of its own, and placed. That costs an mmap,
+ * an mbind and a munmap per row, which rows of a page or two feel. The placement is a
+ * hint: where the OS refuses it, first touch decides, and refused() counts the row.
+ */
+struct NumaPolicy {
+    /**
+     * @return the placement of newly allocated rows, numa_first_touch by default.
+     */
+    static numa_placement& placement () {
+        static numa_placement p = numa_first_touch;
+        return p;}
+
+    /**
+     * @return the node of numa_bind, 0 by default.
+     */
+    static int& node () {
+        static int n = 0;
+        return n;}
+
+    /**
+     * @return the number of elements from which the row loops go parallel.
+     */
+    static std::size_t& grain () {
+        static std::size_t g = std::size_t(1) << 16;
+        return g;}
+
+    /**
+     * @return the number of rows whose placement the OS refused, 0 at first.
+     */
+    static std::size_t& refused () {
+        static std::size_t n = 0;
+        return n;}};
+
+// -----------
+// numa_mapped
+// -----------
+
+/**
+ * @return whether a block of the given bytes and placement is mapped from the OS.
+ */
+inline bool numa_mapped (std::size_t bytes, numa_placement placement) {
+#ifdef __linux__
+    if (placement == numa_first_touch)
+        return false;
+    return bytes >= static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+    (void) bytes;
+    (void) placement;
+    return false;
+#endif
+    }
+
+// --------
+// numa_map
+// --------
+
+/**
+ * Maps fresh, zeroed pages for a block, starting on a page of its own, and
+ * applies the placement to them. A refusal counts in NumaPolicy::refused().
+ * @param bytes the size of the block, numa_mapped()
+ * @param placement how to place its pages
+ * @param node the node of numa_bind
+ * @return the block
+ * @throws bad_alloc
+ */
+inline void* numa_map (std::size_t bytes, numa_placement placement, int node) {
+#ifdef __linux__
+    void* p = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        throw std::bad_alloc();
+    const int           bits = 8 * sizeof(unsigned long);
+    const unsigned long mask = (placement == numa_interleave) ? ~0UL : (node >= 0) && (node < bits) ? (1UL << node) : 0UL;
+    const int           mode = (placement == numa_interleave) ? 3 : 2;      // MPOL_INTERLEAVE, MPOL_BIND
+    if ((mask == 0) || (syscall(SYS_mbind, p, bytes, mode, &mask, bits + 1, 0) != 0))
+        __sync_fetch_and_add(&NumaPolicy::refused(), std::size_t(1));      // rows are placed by any thread
+    return p;
+#else
+    (void) bytes;
+    (void) placement;
+    (void) node;
+    throw std::bad_alloc();
+#endif
+    }
+
+// ----------
+// numa_unmap
+// ----------
+
+/**
+ * @param p a block from numa_map()
+ * @param bytes its size
+ */
+inline void numa_unmap (void* p, std::size_t bytes) {
+#ifdef __linux__
+    munmap(p, bytes);
+#else
+    (void) p;
+    (void) bytes;
+#endif
+    }
+
+// ----------------
+// matrix_allocator
+// ----------------
+
+/**
+ * The allocator of the rows of a Matrix.
+ *
+ * A zeroed allocator gets its memory from calloc, which hands large blocks out as
+ * fresh pages that the OS zeroes lazily, on first touch. A row built from a range of
+ * zero_iterators (with C++11) then trusts those zeros for calloc_zero types instead
+ * of writing them, so a large zero matrix costs no pass over its memory at all.
+ * Every other construction, resize(n) and the like included, value-initializes.
+ *
+ * A placed allocator (see NumaPolicy), which Matrix makes for its large matrices,
+ * maps its blocks of a page or more from the OS instead, already zero.
+ *
+ * deallocate() tells a mapped block from a malloc'd one by its size and the
+ * placement, so only allocators that are both placed or both not can free each
+ * other's blocks (see operator ==). Every allocator travels with its blocks on
+ * swap and move, so that a row is freed, and keeps growing, the way it was made.
+ */
+template <typename T>
+class matrix_allocator {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef T              value_type;
+        typedef T*             pointer;
+        typedef const T*       const_pointer;
+        typedef T&             reference;
+        typedef const T&       const_reference;
+        typedef std::size_t    size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        template <typename U>
+        struct rebind {
+            typedef matrix_allocator<U> other;};
+
+#if __cplusplus >= 201103L
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+#endif
+
+    private:
+        // ----
+        // data
+        // ----
+
+        bool           _zeroed;
+        numa_placement _placement;
+        int            _node;
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        matrix_allocator () :
+                _zeroed(false), _placement(numa_first_touch), _node(0) {}
+
+        /**
+         * @param zeroed whether to get zeroed memory from calloc.
+         */
+        explicit matrix_allocator (bool zeroed) :
+                _zeroed(zeroed), _placement(numa_first_touch), _node(0) {}
+
+        /**
+         * @param zeroed whether to get zeroed memory.
+         * @param placement how to place the pages of blocks of a page or more.
+         * @param node the node of numa_bind.
+         */
+        matrix_allocator (bool zeroed, numa_placement placement, int node) :
+                _zeroed(zeroed), _placement(placement), _node(node) {}
+
+        /**
+         * Copies member by member, so that the compiler still sees a literal zeroed
+         * through the copy in a vector and drops its pass over a zero_iterator range.
+         */
+        matrix_allocator (const matrix_allocator& that) :
+                _zeroed(that._zeroed), _placement(that._placement), _node(that._node) {}
+
+        matrix_allocator& operator = (const matrix_allocator& that) {
+            _zeroed    = that._zeroed;
+            _placement = that._placement;
+            _node      = that._node;
+            return *this;}
+
+        template <typename U>
+        matrix_allocator (const matrix_allocator<U>& that) :
+                _zeroed(that.zeroed()), _placement(that.placement()), _node(that.node()) {}
+
+        bool zeroed () const {
+            return _zeroed;}
+
+        numa_placement placement () const {
+            return _placement;}
+
+        int node () const {
+            return _node;}
+
+#if __cplusplus >= 201103L
+        /**
+         * @return a plain allocator for copies, which are written in full anyway,
+         * placed like the original.
+         */
+        matrix_allocator select_on_container_copy_construction () const {
+            return matrix_allocator(false, _placement, _node);}
+#endif
+
+        // --------
+        // allocate
+        // --------
+
+        pointer allocate (size_type n, const void* = 0) {
+            if (n == 0)
+                return 0;
+            if (n > max_size())
+                throw std::bad_alloc();
+            const size_type bytes = n * sizeof(T);
+            if (numa_mapped(bytes, _placement))
+                return static_cast<pointer>(numa_map(bytes, _placement, _node));
+            void* p = _zeroed ? std::calloc(bytes, 1) : std::malloc(bytes);
+            if (p == 0)
+                throw std::bad_alloc();
+            return static_cast<pointer>(p);}
+
+        void deallocate (pointer p, size_type n) {
+            if (p == 0)
+                return;
+            if (numa_mapped(n * sizeof(T), _placement))
+                numa_unmap(p, n * sizeof(T));
+            else
+                std::free(p);}
+
+        size_type max_size () const {
+            return size_type(-1) / sizeof(T);}
+
+        // ---------
+        // construct
+        // ---------
+
+        void construct (pointer p, const T& v) {
+            ::new (static_cast<void*>(p)) T(v);}
+
+#if __cplusplus >= 201103L
+        template <typename U, typename... Args>
+        void construct (U* p, Args&&... args) {
+            ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);}
+
+        /**
+         * Constructs an element of a block that was just allocated, see zero_iterator.
+         */
+        template <typename U>
+        void construct (U* p, const zero_fill&) {
+            if (!_zeroed || !calloc_zero<U>::value)
+                ::new (static_cast<void*>(p)) U();}
+#endif
+
+        void destroy (pointer p) {
+            p->~T();}
+
+        pointer address (reference r) const {
+            return &r;}
+
+        const_pointer address (const_reference r) const {
+            return &r;}};
+
+template <typename T, typename U>
+bool operator == (const matrix_allocator<T>& lhs, const matrix_allocator<U>& rhs) {
+    return (lhs.placement() == numa_first_touch) == (rhs.placement() == numa_first_touch);}
+
+template <typename T, typename U>
+bool operator != (const matrix_allocator<T>& lhs, const matrix_allocator<U>& rhs) {
+    return !(lhs == rhs);}
+
+#endif // Allocator_h
@@ -0,0 +1,421 @@
+// -----------------------
+// projects/matlab/Async.h
+// Copyright (C) 2012
+// Glenn P. Downing
+// -----------------------
+
+#ifndef Async_h
+#define Async_h
+
+/**
+ * Asynchronous Matrix operations (requires C++11 and -pthread).
+ *
+ * launch() runs a function on a thread pool and returns a Future of its result;
+ * then() and the overloads below take Futures and return a Future, so a chain of
+ * calls builds a task graph. A task starts as soon as all of its inputs are ready,
+ * tasks whose inputs are independent run concurrently, and nothing blocks until
+ * get() is called. An exception (e.g. a DimensionException) thrown by a task is
+ * rethrown by get() of that task and of every task that depends on it.
+ *
+ *     Future< Matrix<double> > x = launch(load_batch1);    // load_batch1 is any callable
+ *     Future< Matrix<double> > y = launch(load_batch2);    // loads in parallel with x
+ *     Future< Matrix<double> > z = transpose(x * y + x);   // runs when x and y are in
+ *     Matrix<double> result = z.get();
+ *
+ * Do not call get() inside a task on a Future that is not ready; pass it to then().
+ *
+ * A task runs on the Executor given to launch() or then(); without one, on the
+ * Executor of its first input that has one, so a graph launched on a pool stays
+ * on it, and on Executor::instance() otherwise. An Executor must outlive the
+ * Futures made on it. Pool threads share the cores with the OpenMP row loops of
+ * the operations they run (products, Strassen, eye, the decompositions), so each
+ * limits its OpenMP regions to omp_get_max_threads() / size() threads (at least 1)
+ * instead of oversubscribing the cores.
+ */
+
+#if __cplusplus < 201103L
+#error "Async.h requires C++11"
+#endif
+
+// --------
+// includes
+// --------
+
+#include <condition_variable> // condition_variable
+#include <cstddef>            // size_t
+#include <deque>              // deque
+#include <exception>          // exception_ptr, current_exception, rethrow_exception
+#include <functional>         // function
+#include <memory>             // shared_ptr, make_shared
+#include <mutex>              // mutex, unique_lock
+#include <thread>             // thread
+#include <tuple>              // tuple, get
+#include <type_traits>        // decay
+#include <utility>            // declval, move
+#include <vector>             // vector
+
+#ifdef _OPENMP
+#include <omp.h> // omp_get_max_threads, omp_set_num_threads
+#endif
+
+#include "Matrix.h"
+#include "Matlab.h"
+
+// --------
+// Executor
+// --------
+
+/**
+ * A fixed pool of threads running jobs in submission order.
+ * The destructor runs the jobs already submitted, then joins the threads.
+ */
+class Executor {
+    private:
+        std::mutex                        _lock;
+        std::condition_variable           _wake;
+        std::deque< std::function<void()> > _jobs;
+        std::vector<std::thread>          _threads;
+        bool                              _stop;
+
+        void work (std::size_t threads) {
+#ifdef _OPENMP
+            const int share = omp_get_max_threads() / static_cast<int>(threads);
+            omp_set_num_threads(share > 1 ? share : 1);           // this thread's OpenMP regions
+#else
+            (void) threads;
+#endif
+            for (;;) {
+                std::function<void()> job;
+                {
+                std::unique_lock<std::mutex> guard(_lock);
+                _wake.wait(guard, [this] {return _stop || !_jobs.empty();});
+                if (_jobs.empty())
+                    return;
+                job = std::move(_jobs.front());
+                _jobs.pop_front();
+                }
+                job();}}
+
+        Executor            (const Executor&);
+        Executor& operator = (const Executor&);
+
+    public:
+        /**
+         * @param threads the number of threads (the number of cores by default).
+         */
+        explicit Executor (std::size_t threads = std::thread::hardware_concurrency()) :
+                _stop(false) {
+            if (threads == 0)
+                threads = 1;
+            for (std::size_t i = 0; i < threads; ++i)
+                _threads.push_back(std::thread(&Executor::work, this, threads));}
+
+        ~Executor () {
+            {
+            std::lock_guard<std::mutex> guard(_lock);
+            _stop = true;
+            }
+            _wake.notify_all();
+            for (std::size_t i = 0; i < _threads.size(); ++i)
+                _threads[i].join();}
+
+        /**
+         * @return the pool used when none is given.
+         */
+        static Executor& instance () {
+            static Executor e;
+            return e;}
+
+        /**
+         * Used to queue a job; jobs must not throw.
+         */
+        void submit (std::function<void()> job) {
+            {
+            std::lock_guard<std::mutex> guard(_lock);
+            _jobs.push_back(std::move(job));
+            }
+            _wake.notify_one();}
+
+        std::size_t size () const {
+            return _threads.size();}};
+
+// ------
+// Future
+// ------
+
+/**
+ * The eventual result of a task. Copies share the same result.
+ */
+template <typename R>
+class Future {
+    private:
+        struct State {
+            std::mutex                          lock;
+            std::condition_variable             done_signal;
+            bool                                done;
+            R                                   value;
+            std::exception_ptr                  error;
+            std::vector< std::function<void()> > continuations;
+            Executor*                           executor;
+
+            explicit State (Executor* e) : done(false), value(), executor(e) {}};
+
+        std::shared_ptr<State> _s;
+
+        void finish (R* value, std::exception_ptr error) {
+            std::vector< std::function<void()> > continuations;
+            {
+            std::lock_guard<std::mutex> guard(_s->lock);
+            if (value)
+                _s->value = std::move(*value);
+            _s->error = error;
+            _s->done  = true;
+            continuations.swap(_s->continuations);
+            }
+            _s->done_signal.notify_all();
+            for (std::size_t i = 0; i < continuations.size(); ++i)
+                continuations[i]();}
+
+    public:
+        /**
+         * @param e the Executor of the task that completes this Future, if any.
+         */
+        explicit Future (Executor* e = 0) : _s(std::make_shared<State>(e)) {}
+
+        // --------
+        // executor
+        // --------
+
+        /**
+         * @return the Executor of the task that completes this Future, 0 for ready().
+         */
+        Executor* executor () const {
+            return _s->executor;}
+
+        // -----
+        // ready
+        // -----
+
+        /**
+         * @return whether the result (or its exception) is available.
+         */
+        bool ready () const {
+            std::lock_guard<std::mutex> guard(_s->lock);
+            return _s->done;}
+
+        // ----
+        // wait
+        // ----
+
+        /**
+         * Used to block until the result is available.
+         */
+        void wait () const {
+            std::unique_lock<std::mutex> guard(_s->lock);
+            _s->done_signal.wait(guard, [this] {return _s->done;});}
+
+        // ---
+        // get
+        // ---
+
+        /**
+         * Used to block until the result is available.
+         * @return the result; rethrows the exception of the task if it failed.
+         */
+        const R& get () const {
+            wait();
+            if (_s->error)
+                std::rethrow_exception(_s->error);
+            return _s->value;}
+
+        // --------
+        // on_ready
+        // --------
+
+        /**
+         * Used to run f once the result is available: right away if it already is,
+         * otherwise on the thread that completes it.
+         */
+        void on_ready (std::function<void()> f) const {
+            {
+            std::lock_guard<std::mutex> guard(_s->lock);
+            if (!_s->done) {
+                _s->continuations.push_back(std::move(f));
+                return;}
+            }
+            f();}
+
+        // ---------------------
+        // set_value, set_error
+        // ---------------------
+
+        void set_value (R value) {
+            finish(&value, std::exception_ptr());}
+
+        void set_error (std::exception_ptr error) {
+            finish(0, error);}};
+
+// ------------
+// Continuation
+// ------------
+
+/**
+ * The node of the task graph that applies f to the results of its inputs
+ * once the last of them is ready.
+ */
+template <typename F, typename... Args>
+class Continuation {
+    public:
+        typedef typename std::decay<decltype(std::declval<F&>()(std::declval<const Args&>()...))>::type result_type;
+
+    private:
+        std::mutex                               _lock;
+        std::size_t                              _pending;
+        F                                        _f;
+        std::tuple< Future<Args>... >            _inputs;
+        Future<result_type>                      _output;
+        Executor&                                _executor;
+
+        template <std::size_t... I>
+        struct indices {};
+
+        template <std::size_t N, std::size_t... I>
+        struct make_indices : make_indices<N - 1, N - 1, I...> {};
+
+        template <std::size_t... I>
+        struct make_indices<0, I...> : indices<I...> {};
+
+        template <std::size_t... I>
+        result_type call (indices<I...>) {
+            return _f(std::get<I>(_inputs).get()...);}
+
+        void run () {
+            try {
+                _output.set_value(call(make_indices<sizeof...(Args)>()));}
+            catch (...) {
+                _output.set_error(std::current_exception());}}
+
+    public:
+        Continuation (F f, Executor& e, const Future<Args>&... inputs) :
+                _pending(sizeof...(Args) + 1),
+                _f(std::move(f)),
+                _inputs(inputs...),
+                _output(&e),
+                _executor(e) {}
+
+        Future<result_type> output () const {
+            return _output;}
+
+        /**
+         * Used to count down one ready input; the last one schedules the task.
+         */
+        static void arrive (const std::shared_ptr<Continuation>& self) {
+            bool last;
+            {
+            std::lock_guard<std::mutex> guard(self->_lock);
+            last = --self->_pending == 0;
+            }
+            if (last) {
+                std::shared_ptr<Continuation> c = self;
+                self->_executor.submit([c] {c->run();});}}};
+
+// ------
+// launch
+// ------
+
+/**
+ * Used to run f() on a pool.
+ * @param f a callable taking no arguments, e.g. one loading a matrix from a file.
+ * @param e the pool (Executor::instance() by default).
+ * @return the Future of f().
+ */
+template <typename F>
+Future<typename Continuation<F>::result_type> launch (F f, Executor& e = Executor::instance()) {
+    std::shared_ptr< Continuation<F> > c = std::make_shared< Continuation<F> >(std::move(f), e);
+    Continuation<F>::arrive(c);
+    return c->output();}
+
+// -----------
+// executor_of
+// -----------
+
+/**
+ * @return the Executor of the first of the inputs that has one, Executor::instance() if none.
+ */
+inline Executor& executor_of () {
+    return Executor::instance();}
+
+template <typename A, typename... Args>
+Executor& executor_of (const Future<A>& first, const Future<Args>&... rest) {
+    return first.executor() ? *first.executor() : executor_of(rest...);}
+
+// ----
+// then
+// ----
+
+/**
+ * Used to run f(inputs.get()...) on a pool once all of the inputs are ready.
+ * @param e the pool.
+ * @param f a callable taking the results of the inputs.
+ * @param inputs the Futures whose results f takes.
+ * @return the Future of f(inputs.get()...).
+ */
+template <typename F, typename... Args>
+Future<typename Continuation<F, Args...>::result_type> then (Executor& e, F f, const Future<Args>&... inputs) {
+    typedef Continuation<F, Args...> node_type;
+    std::shared_ptr<node_type> c = std::make_shared<node_type>(std::move(f), e, inputs...);
+    int expand[] = {0, (inputs.on_ready([c] {node_type::arrive(c);}), 0)...};
+    (void) expand;
+    node_type::arrive(c);
+    return c->output();}
+
+/**
+ * Used to run f(inputs.get()...) on the pool of the inputs, see executor_of().
+ */
+template <typename F, typename... Args>
+Future<typename Continuation<F, Args...>::result_type> then (F f, const Future<Args>&... inputs) {
+    return then(executor_of(inputs...), std::move(f), inputs...);}
+
+// -----
+// ready
+// -----
+
+/**
+ * @param value a result that is already available.
+ * @return a Future holding value, to feed it to then().
+ */
+template <typename R>
+Future<R> ready (R value) {
+    Future<R> f;
+    f.set_value(std::move(value));
+    return f;}
+
+// -----------------------------
+// operators on Future< Matrix >
+// -----------------------------
+
+template <typename T, typename C>
+Future< Matrix<T, C> > operator + (const Future< Matrix<T, C> >& lhs, const Future< Matrix<T, C> >& rhs) {
+    return then([] (const Matrix<T, C>& x, const Matrix<T, C>& y) {return x + y;}, lhs, rhs);}
+
+template <typename T, typename C>
+Future< Matrix<T, C> > operator - (const Future< Matrix<T, C> >& lhs, const Future< Matrix<T, C> >& rhs) {
+    return then([] (const Matrix<T, C>& x, const Matrix<T, C>& y) {return x - y;}, lhs, rhs);}
+
+template <typename T, typename C>
+Future< Matrix<T, C> > operator * (const Future< Matrix<T, C> >& lhs, const Future< Matrix<T, C> >& rhs) {
+    return then([] (const Matrix<T, C>& x, const Matrix<T, C>& y) {return x * y;}, lhs, rhs);}
+
+// ------------------------
+// Matlab on Future< Matrix >
+// ------------------------
+
+template <typename T, typename C>
+Future< Matrix<T, C> > transpose (const Future< Matrix<T, C> >& x) {
+    return then([] (const Matrix<T, C>& m) {return transpose(m);}, x);}
+
+template <typename T, typename C>
+Future< Matrix<T, C> > mtimes (const Future< Matrix<T, C> >& x, const Future< Matrix<T, C> >& y, product_algorithm a) {
+    return then([a] (const Matrix<T, C>& m, const Matrix<T, C>& n) {return mtimes(m, n, a);}, x, y);}
+
+#endif // Async_h
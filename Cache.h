@@ -0,0 +1,573 @@
+// -----------------------
+// projects/matlab/Cache.h
+// Copyright (C) 2012
+// Glenn P. Downing
+// -----------------------
+
+#ifndef Cache_h
+#define Cache_h
+
+/**
+ * An opt-in, persistent cache of Matrix results (requires C++11).
+ *
+ * memoize() keys a computation by its name and the contents of its inputs, so
+ * unchanged inputs find the earlier result and changed ones miss; there is nothing
+ * to invalidate by hand:
+ *
+ *     Matrix<double> g = memoize("gram", [] (const Matrix<double>& x) {return transpose(x) * x;}, x);
+ *
+ * Results live in a least-recently-used table bounded in bytes. With a directory,
+ * the entries evicted from memory are spilled to files there, and flush() (run by
+ * the destructor) writes the rest, so a later run of the same program starts with
+ * them: rerunning a workflow after a small edit recomputes only what the edit
+ * changed. The directory must exist. Files are written under a temporary name unique
+ * to the process and the cache, and renamed, so processes may share a directory;
+ * files that cannot be read or do not match are ignored. Nothing ever removes files
+ * from the directory, which grows by one file per distinct result spilled: it is only
+ * an optimization, and may be emptied or deleted whenever no cache is using it.
+ *
+ * The name must identify the computation: two functions memoized under the same
+ * name with the same inputs share a result. Inputs are hashed with their types, so
+ * a Matrix<int> and a Matrix<float> with the same bits are different inputs.
+ */
+
+#if __cplusplus < 201103L
+#error "Cache.h requires C++11"
+#endif
+
+// --------
+// includes
+// --------
+
+#include <algorithm>     // min
+#include <cstddef>       // size_t
+#include <cstdint>       // uint32_t, uint64_t
+#include <cstdio>        // remove, rename, snprintf
+#include <cstring>       // memcpy, strlen
+#include <fstream>       // ifstream, ofstream
+#include <list>          // list
+#include <mutex>         // mutex, lock_guard
+#include <string>        // string
+#include <type_traits>   // decay, enable_if, is_arithmetic, is_enum, is_trivially_copyable
+#include <typeinfo>      // typeid
+#include <unordered_map> // unordered_map
+#include <utility>       // declval, move
+#include <vector>        // vector
+
+#include <unistd.h>      // getpid
+
+#include "Matrix.h"
+
+// -----------
+// ContentHash
+// -----------
+
+/**
+ * A fast 64-bit hash of a byte stream, after xxHash64: four independent lanes each
+ * take 8 bytes of every 32-byte stripe, so the multiplies of a stripe overlap in
+ * the pipeline (or vectorize), at several GB/s. The hash of a stream does not
+ * depend on how it is split into update() calls. Not cryptographic.
+ */
+class ContentHash {
+    private:
+        static const std::uint64_t p1 = 11400714785074694791ULL;
+        static const std::uint64_t p2 = 14029467366897019727ULL;
+        static const std::uint64_t p3 =  1609587929392839161ULL;
+        static const std::uint64_t p4 =  9650029242287828579ULL;
+        static const std::uint64_t p5 =  2870177450012600261ULL;
+
+        std::uint64_t _seed;
+        std::uint64_t _lane[4];
+        unsigned char _buffer[32];
+        std::size_t   _buffered;
+        std::uint64_t _total;
+
+        static std::uint64_t rotl (std::uint64_t x, int r) {
+            return (x << r) | (x >> (64 - r));}
+
+        static std::uint64_t mix (std::uint64_t lane, std::uint64_t input) {
+            return rotl(lane + input * p2, 31) * p1;}
+
+        static std::uint64_t load (const unsigned char* p) {
+            std::uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;}
+
+        void stripe (const unsigned char* p) {
+            _lane[0] = mix(_lane[0], load(p));
+            _lane[1] = mix(_lane[1], load(p + 8));
+            _lane[2] = mix(_lane[2], load(p + 16));
+            _lane[3] = mix(_lane[3], load(p + 24));}
+
+    public:
+        explicit ContentHash (std::uint64_t seed = 0) :
+                _seed(seed),
+                _buffered(0),
+                _total(0) {
+            _lane[0] = seed + p1 + p2;
+            _lane[1] = seed + p2;
+            _lane[2] = seed;
+            _lane[3] = seed - p1;}
+
+        /**
+         * Used to hash n more bytes.
+         */
+        ContentHash& update (const void* data, std::size_t n) {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            _total += n;
+            if (_buffered != 0) {
+                const std::size_t k = std::min(n, sizeof(_buffer) - _buffered);
+                std::memcpy(_buffer + _buffered, p, k);
+                _buffered += k;
+                p         += k;
+                n         -= k;
+                if (_buffered < sizeof(_buffer))
+                    return *this;
+                stripe(_buffer);
+                _buffered = 0;}
+            for (; n >= sizeof(_buffer); p += sizeof(_buffer), n -= sizeof(_buffer))
+                stripe(p);
+            std::memcpy(_buffer, p, n);
+            _buffered = n;
+            return *this;}
+
+        /**
+         * @return the hash of the bytes so far.
+         */
+        std::uint64_t digest () const {
+            std::uint64_t h;
+            if (_total >= sizeof(_buffer)) {
+                h = rotl(_lane[0], 1) + rotl(_lane[1], 7) + rotl(_lane[2], 12) + rotl(_lane[3], 18);
+                for (int i = 0; i < 4; ++i)
+                    h = (h ^ mix(0, _lane[i])) * p1 + p4;}
+            else
+                h = _seed + p5;
+            h += _total;
+            const unsigned char* p = _buffer;
+            std::size_t          n = _buffered;
+            for (; n >= 8; p += 8, n -= 8)
+                h = rotl(h ^ mix(0, load(p)), 27) * p1 + p4;
+            if (n >= 4) {
+                std::uint32_t v;
+                std::memcpy(&v, p, sizeof(v));
+                h  = rotl(h ^ (v * p1), 23) * p2 + p3;
+                p += 4;
+                n -= 4;}
+            for (; n != 0; ++p, --n)
+                h = rotl(h ^ (*p * p5), 11) * p1;
+            h ^= h >> 33;
+            h *= p2;
+            h ^= h >> 29;
+            h *= p3;
+            h ^= h >> 32;
+            return h;}};
+
+// ------------
+// content_hash
+// ------------
+
+/**
+ * Used to hash the name and the size of the type T, so that equal bits of
+ * different types hash differently.
+ */
+template <typename T>
+void content_hash_type (ContentHash& h) {
+    const char*         name = typeid(T).name();
+    const std::uint64_t size = sizeof(T);
+    h.update(name, std::strlen(name)).update(&size, sizeof(size));}
+
+template <typename T, typename A>
+void content_hash_row (ContentHash& h, const std::vector<T, A>& row) {
+    static_assert(std::is_trivially_copyable<T>::value, "content_hash needs trivially copyable elements");
+    if (!row.empty())
+        h.update(&row[0], row.size() * sizeof(T));}
+
+template <typename A>
+void content_hash_row (ContentHash& h, const std::vector<bool, A>& row) {
+    unsigned char bytes[256];
+    for (std::size_t i = 0; i < row.size(); i += sizeof(bytes)) {
+        const std::size_t n = std::min(sizeof(bytes), row.size() - i);
+        for (std::size_t j = 0; j < n; ++j)
+            bytes[j] = row[i + j];
+        h.update(bytes, n);}}
+
+/**
+ * @return the hash of the element type, the shape and the elements of x.
+ */
+template <typename T, typename C>
+std::uint64_t content_hash (const Matrix<T, C>& x) {
+    ContentHash h;
+    content_hash_type<T>(h);
+    const std::uint64_t shape[2] = {x.rows(), x.columns()};
+    h.update(shape, sizeof(shape));
+    for (std::size_t r = 0; r < x.rows(); ++r)
+        content_hash_row(h, x[r]);
+    return h.digest();}
+
+/**
+ * @return the hash of the type and the value of a scalar argument, e.g. a
+ * product_algorithm or a count.
+ */
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value, std::uint64_t>::type
+content_hash (const T& v) {
+    ContentHash h;
+    content_hash_type<T>(h);
+    return h.update(&v, sizeof(v)).digest();}
+
+// ----------------------------------
+// cache_serialize, cache_deserialize
+// ----------------------------------
+
+template <typename T, typename A>
+void cache_write_row (std::string& bytes, const std::vector<T, A>& row) {
+    if (!row.empty())
+        bytes.append(reinterpret_cast<const char*>(&row[0]), row.size() * sizeof(T));}
+
+template <typename A>
+void cache_write_row (std::string& bytes, const std::vector<bool, A>& row) {
+    for (std::size_t i = 0; i < row.size(); ++i)
+        bytes += char(row[i]);}
+
+template <typename T, typename A>
+void cache_read_row (const char* p, std::vector<T, A>& row) {
+    if (!row.empty())
+        std::memcpy(&row[0], p, row.size() * sizeof(T));}
+
+template <typename A>
+void cache_read_row (const char* p, std::vector<bool, A>& row) {
+    for (std::size_t i = 0; i < row.size(); ++i)
+        row[i] = p[i] != 0;}
+
+/**
+ * @return the shape and the elements of x as bytes.
+ */
+template <typename T, typename C>
+std::string cache_serialize (const Matrix<T, C>& x) {
+    static_assert(std::is_trivially_copyable<T>::value, "the cache needs trivially copyable elements");
+    const std::uint64_t header[3] = {x.rows(), x.columns(), sizeof(T)};
+    std::string bytes(reinterpret_cast<const char*>(header), sizeof(header));
+    bytes.reserve(sizeof(header) + x.rows() * x.columns() * sizeof(T));
+    for (std::size_t r = 0; r < x.rows(); ++r)
+        cache_write_row(bytes, x[r]);
+    return bytes;}
+
+/**
+ * Used to rebuild a matrix from cache_serialize().
+ * The shape must account for the elements exactly, so a corrupt header never
+ * allocates; matrices with rows but no columns are not restored.
+ * @return false, leaving x alone, if the bytes do not hold a matrix of x's type.
+ */
+template <typename T, typename C>
+bool cache_deserialize (const std::string& bytes, Matrix<T, C>& x) {
+    std::uint64_t header[3];
+    if (bytes.size() < sizeof(header))
+        return false;
+    std::memcpy(header, bytes.data(), sizeof(header));
+    const std::uint64_t payload = bytes.size() - sizeof(header);
+    if (header[2] != sizeof(T) || payload % sizeof(T) != 0)
+        return false;
+    const std::uint64_t elements = payload / sizeof(T);
+    if (header[1] == 0 ? header[0] != 0 : (header[0] > elements / header[1] || header[0] * header[1] != elements))
+        return false;
+    Matrix<T, C> result(header[0], header[1]);
+    for (std::size_t r = 0; r < header[0]; ++r)
+        cache_read_row(bytes.data() + sizeof(header) + r * header[1] * sizeof(T), result[r]);
+    x = std::move(result);
+    return true;}
+
+// -----------
+// MatrixCache
+// -----------
+
+/**
+ * A thread-safe table from keys to serialized results, least recently used first
+ * out, with an optional directory to spill to and reload from.
+ */
+class MatrixCache {
+    public:
+        struct Statistics {
+            std::size_t hits;      // found in memory
+            std::size_t disk_hits; // found in the directory
+            std::size_t misses;
+            std::size_t evictions; // dropped from memory
+            std::size_t spills;    // written to the directory
+
+            Statistics () : hits(0), disk_hits(0), misses(0), evictions(0), spills(0) {}};
+
+    private:
+        struct Entry {
+            std::string key;
+            std::string bytes;
+            bool        on_disk;};
+
+        typedef std::list<Entry>::iterator iterator;
+
+        mutable std::mutex                         _lock;
+        std::list<Entry>                           _entries; // most recently used first
+        std::unordered_map<std::string, iterator>  _index;
+        std::size_t                                _budget;
+        std::size_t                                _bytes;
+        std::string                                _directory;
+        Statistics                                 _statistics;
+
+        MatrixCache            (const MatrixCache&);
+        MatrixCache& operator = (const MatrixCache&);
+
+        std::string path (const std::string& key) const {
+            char name[32];
+            std::snprintf(name, sizeof(name), "%016llx.mtx",
+                          static_cast<unsigned long long>(ContentHash().update(key.data(), key.size()).digest()));
+            return _directory + "/" + name;}
+
+        /**
+         * Used to write an entry to the directory, whole or not at all.
+         */
+        bool write (const Entry& e) {
+            const std::string file = path(e.key);
+            char suffix[64];
+            std::snprintf(suffix, sizeof(suffix), ".%ld.%p.tmp", static_cast<long>(getpid()), static_cast<const void*>(this));
+            const std::string temp = file + suffix;
+            {
+            std::ofstream out(temp.c_str(), std::ios::binary | std::ios::trunc);
+            const std::uint64_t sizes[2] = {e.key.size(), e.bytes.size()};
+            out.write("MTXCACHE", 8);
+            out.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+            out.write(e.key.data(), e.key.size());
+            out.write(e.bytes.data(), e.bytes.size());
+            if (!out.flush()) {
+                out.close();
+                std::remove(temp.c_str());
+                return false;}
+            }
+            if (std::rename(temp.c_str(), file.c_str()) != 0) {
+                std::remove(temp.c_str());
+                return false;}
+            ++_statistics.spills;
+            return true;}
+
+        /**
+         * Used to read the entry of key from the directory.
+         */
+        bool read (const std::string& key, std::string& bytes) const {
+            std::ifstream in(path(key).c_str(), std::ios::binary);
+            char          magic[8];
+            std::uint64_t sizes[2];
+            if (!in.read(magic, 8) || std::memcmp(magic, "MTXCACHE", 8) != 0)
+                return false;
+            if (!in.read(reinterpret_cast<char*>(sizes), sizeof(sizes)) || sizes[0] != key.size())
+                return false;
+            std::string stored(key.size(), '\0');
+            if (!key.empty() && (!in.read(&stored[0], key.size()) || stored != key))
+                return false;
+            std::string result(sizes[1], '\0');
+            if (sizes[1] != 0 && !in.read(&result[0], sizes[1]))
+                return false;
+            bytes.swap(result);
+            return true;}
+
+        /**
+         * Used to drop the least recently used entries until the rest fit the budget.
+         */
+        void trim () {
+            while (_bytes > _budget && !_entries.empty()) {
+                Entry& e = _entries.back();
+                if (!_directory.empty() && !e.on_disk)
+                    write(e);
+                _bytes -= e.bytes.size();
+                _index.erase(e.key);
+                _entries.pop_back();
+                ++_statistics.evictions;}}
+
+        void add (const std::string& key, std::string bytes, bool on_disk) {
+            const std::unordered_map<std::string, iterator>::iterator i = _index.find(key);
+            if (i != _index.end()) {
+                _bytes -= i->second->bytes.size();
+                _entries.erase(i->second);
+                _index.erase(i);}
+            Entry e = {key, std::string(), on_disk};
+            e.bytes.swap(bytes);
+            _bytes += e.bytes.size();
+            _entries.push_front(std::move(e));
+            _index[key] = _entries.begin();
+            trim();}
+
+    public:
+        /**
+         * @param budget the most bytes of results to hold in memory.
+         * @param directory the directory to spill to and reload from; none if empty.
+         */
+        explicit MatrixCache (std::size_t budget = std::size_t(256) << 20, const std::string& directory = "") :
+                _budget(budget),
+                _bytes(0),
+                _directory(directory) {}
+
+        ~MatrixCache () {
+            flush();}
+
+        /**
+         * @return the cache memoize() uses when none is given.
+         */
+        static MatrixCache& instance () {
+            static MatrixCache c;
+            return c;}
+
+        // -----------------
+        // budget, directory
+        // -----------------
+
+        std::size_t budget () const {
+            std::lock_guard<std::mutex> guard(_lock);
+            return _budget;}
+
+        void budget (std::size_t bytes) {
+            std::lock_guard<std::mutex> guard(_lock);
+            _budget = bytes;
+            trim();}
+
+        std::string directory () const {
+            std::lock_guard<std::mutex> guard(_lock);
+            return _directory;}
+
+        /**
+         * @param d the directory to spill to and reload from; none if empty. It is
+         * never trimmed (see above).
+         */
+        void directory (const std::string& d) {
+            std::lock_guard<std::mutex> guard(_lock);
+            _directory = d;
+            for (iterator i = _entries.begin(); i != _entries.end(); ++i)
+                i->on_disk = false;}
+
+        // -----------------
+        // bytes, statistics
+        // -----------------
+
+        std::size_t bytes () const {
+            std::lock_guard<std::mutex> guard(_lock);
+            return _bytes;}
+
+        Statistics statistics () const {
+            std::lock_guard<std::mutex> guard(_lock);
+            return _statistics;}
+
+        // ----
+        // find
+        // ----
+
+        /**
+         * Used to look up a result, in memory and then in the directory.
+         * @return whether it was found, and then bytes.
+         */
+        bool find (const std::string& key, std::string& bytes) {
+            std::lock_guard<std::mutex> guard(_lock);
+            const std::unordered_map<std::string, iterator>::iterator i = _index.find(key);
+            if (i != _index.end()) {
+                _entries.splice(_entries.begin(), _entries, i->second);
+                bytes = i->second->bytes;
+                ++_statistics.hits;
+                return true;}
+            if (!_directory.empty() && read(key, bytes)) {
+                add(key, bytes, true);
+                ++_statistics.disk_hits;
+                return true;}
+            ++_statistics.misses;
+            return false;}
+
+        // ------
+        // insert
+        // ------
+
+        /**
+         * Used to add a result, the most recently used one.
+         */
+        void insert (const std::string& key, std::string bytes) {
+            std::lock_guard<std::mutex> guard(_lock);
+            add(key, std::move(bytes), false);}
+
+        // -----
+        // flush
+        // -----
+
+        /**
+         * Used to write the results held only in memory to the directory, if any.
+         */
+        void flush () {
+            std::lock_guard<std::mutex> guard(_lock);
+            if (_directory.empty())
+                return;
+            for (iterator i = _entries.begin(); i != _entries.end(); ++i)
+                if (!i->on_disk)
+                    i->on_disk = write(*i);}
+
+        // -----
+        // clear
+        // -----
+
+        /**
+         * Used to forget the results held in memory; the directory is left alone.
+         */
+        void clear () {
+            std::lock_guard<std::mutex> guard(_lock);
+            _entries.clear();
+            _index.clear();
+            _bytes = 0;}};
+
+// ---------
+// cache_key
+// ---------
+
+inline void cache_key_append (std::string&) {}
+
+template <typename T, typename... Args>
+void cache_key_append (std::string& key, const T& input, const Args&... inputs) {
+    char hex[24];
+    std::snprintf(hex, sizeof(hex), ":%016llx", static_cast<unsigned long long>(content_hash(input)));
+    key += hex;
+    cache_key_append(key, inputs...);}
+
+/**
+ * @return the key of the result of type R of op on inputs.
+ */
+template <typename R, typename... Args>
+std::string cache_key (const std::string& op, const Args&... inputs) {
+    std::string key = op;
+    key += ':';
+    key += typeid(R).name();
+    cache_key_append(key, inputs...);
+    return key;}
+
+// -------
+// memoize
+// -------
+
+/**
+ * Used to return the cached result of f(inputs...), computing and caching it on a miss.
+ * @param cache the cache.
+ * @param op the name of the computation.
+ * @param f a callable taking the inputs and returning a Matrix.
+ * @param inputs Matrix or scalar arguments, hashed by content_hash().
+ * @return f(inputs...).
+ */
+template <typename F, typename... Args>
+typename std::decay<decltype(std::declval<F&>()(std::declval<const Args&>()...))>::type
+memoize (MatrixCache& cache, const std::string& op, F f, const Args&... inputs) {
+    typedef typename std::decay<decltype(f(inputs...))>::type result_type;
+    const std::string key = cache_key<result_type>(op, inputs...);
+    std::string bytes;
+    result_type result;
+    if (cache.find(key, bytes) && cache_deserialize(bytes, result))
+        return result;
+    result = f(inputs...);
+    cache.insert(key, cache_serialize(result));
+    return result;}
+
+/**
+ * Used to return the cached result of f(inputs...) from MatrixCache::instance().
+ */
+template <typename F, typename... Args>
+typename std::decay<decltype(std::declval<F&>()(std::declval<const Args&>()...))>::type
+memoize (const std::string& op, F f, const Args&... inputs) {
+    return memoize(MatrixCache::instance(), op, f, inputs...);}
+
+#endif // Cache_h
@@ -0,0 +1,1386 @@
+// -------------------------------
+// projects/matlab/Decomposition.h
+// Copyright (C) 2012
+// Glenn P. Downing
+// -------------------------------
+
+#ifndef Decomposition_h
+#define Decomposition_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // fill, max, min, sort, swap, swap_ranges
+#include <cmath>     // fabs, sqrt
+#include <cstddef>   // ptrdiff_t, size_t
+#include <limits>    // numeric_limits
+#include <string>    // string
+#include <vector>    // vector
+
+#include "Matrix.h"   // numeric_traits
+#include "Profiler.h" // MATRIX_PROFILE_SCOPE
+
+/**
+ * Eigenvalue and singular value decompositions, after EISPACK and JAMA:
+ * - eig():         symmetric matrices; Householder reduction to tridiagonal form,
+ *                  then the implicit QL method.
+ * - eig_general(): any square matrix; Householder reduction to Hessenberg form,
+ *                  then the shifted double-step QR method (eigenvalues only).
+ * - svd():         Householder bidiagonalization, then the implicit QR method of
+ *                  Golub, Kahan and Reinsch.
+ * - svds():        the k largest singular triplets by a randomized range finder
+ *                  (Halko, Martinsson and Tropp, SIAM Review 53(2), 2011).
+ *
+ * The elements must be of a floating-point type; the work is done in their
+ * accumulate_type. The working copies are stored by columns, so that the inner
+ * loops of the reflections and rotations run over contiguous memory. The O(n^2)
+ * update of each reflection runs in parallel over columns, and the rotations of
+ * each QL/QR sweep are collected and applied to the vectors in parallel over
+ * blocks of rows (compile with -fopenmp). svd() forms its singular vectors from
+ * decomposition_panel() reflections at a time in compact WY form; the reductions
+ * themselves still apply one reflection at a time.
+ *
+ * A matrix with a NaN or an Inf (in the lower triangle, for eig()) throws a
+ * ConvergenceException. The iterations are capped at decomposition_sweeps(n), as
+ * in EISPACK; a matrix that does not converge by then also throws one.
+ */
+
+// --------------------
+// ConvergenceException
+// --------------------
+
+/**
+ * The exception thrown when an iterative decomposition does not converge.
+ */
+class ConvergenceException {
+private:
+    const char* op;
+
+public:
+    explicit ConvergenceException(const char* o = 0) : op(o) {}
+
+    /**
+     * @return the message, e.g. "No convergence: svd.\n"
+     */
+    std::string err() const {
+        std::string s = "No convergence";
+        if (op != 0) {
+            s += ": ";
+            s += op;}
+        s += ".\n";
+        return s;}
+};
+
+// -------------------
+// decomposition_grain
+// -------------------
+
+/**
+ * @return the least number of element operations for a loop to run in parallel.
+ */
+inline std::size_t decomposition_grain () {
+    return 32768;}
+
+// -------------------
+// decomposition_panel
+// -------------------
+
+/**
+ * @return the number of reflections that householder_block_reflect() applies at once.
+ */
+inline std::ptrdiff_t decomposition_panel () {
+    return 32;}
+
+// --------------------
+// decomposition_sweeps
+// --------------------
+
+/**
+ * @return the most QL/QR steps an n x n problem may take, 30 per eigenvalue or
+ * singular value (EISPACK, LINPACK).
+ */
+inline std::ptrdiff_t decomposition_sweeps (std::ptrdiff_t n) {
+    return 30 * std::max(n, std::ptrdiff_t(1));}
+
+// -------------------
+// decomposition_hypot
+// -------------------
+
+/**
+ * @return sqrt(a^2 + b^2) without overflow or underflow.
+ */
+template <typename A>
+A decomposition_hypot (A a, A b) {
+    a = std::fabs(a);
+    b = std::fabs(b);
+    if (a < b)
+        std::swap(a, b);
+    if (a == 0)
+        return 0;
+    const A r = b / a;
+    return a * std::sqrt(1 + r * r);}
+
+// ------------------
+// decomposition_norm
+// ------------------
+
+/**
+ * @return the 2-norm of the n elements at x, without overflow or underflow.
+ */
+template <typename A>
+A decomposition_norm (const A* x, std::ptrdiff_t n) {
+    A scale = 0;
+    for (std::ptrdiff_t i = 0; i < n; ++i)
+        scale = std::max(scale, A(std::fabs(x[i])));
+    if (scale == 0)
+        return 0;
+    A sum = 0;
+    for (std::ptrdiff_t i = 0; i < n; ++i) {
+        const A y = x[i] / scale;
+        sum += y * y;}
+    return scale * std::sqrt(sum);}
+
+// --------------------
+// decomposition_finite
+// --------------------
+
+/**
+ * @return whether none of the n elements at x is a NaN or an Inf.
+ */
+template <typename A>
+bool decomposition_finite (const A* x, std::ptrdiff_t n) {
+    for (std::ptrdiff_t i = 0; i < n; ++i)
+        if (!(x[i] - x[i] == 0))
+            return false;
+    return true;}
+
+// -------------------------
+// householder_block_reflect
+// -------------------------
+
+/**
+ * Used to apply the product H_0 H_1 ... H_{b-1} of b Householder reflections,
+ * H_t = I - tau_t v_t v_t', to the columns of c in compact WY form (Schreiber and
+ * Van Loan, SIAM J. Sci. Stat. Comput. 10(1), 1989): the product is I - V T V',
+ * with T upper triangular, so each column takes c -= V (T (V' c)) in one pass
+ * instead of b passes, one per reflection.
+ * @param v the b vectors, by columns ldv apart; v_t is zero above its row t and
+ *          is not read when tau_t is 0.
+ * @param tau the b scalars; 0 for a reflection that is the identity.
+ * @param c the cols columns, ldc apart, of rows elements each.
+ */
+template <typename A>
+void householder_block_reflect (const A* v, std::ptrdiff_t ldv, const A* tau, std::ptrdiff_t b,
+                                A* c, std::ptrdiff_t ldc, std::ptrdiff_t rows, std::ptrdiff_t cols) {
+    // T, by columns: T[j][j] = tau_j, T[0..j)[j] = -tau_j T[0..j)[0..j) V[0..j)' v_j (LAPACK dlarft)
+    std::vector<A> t(b * b);
+    std::vector<A> w(b);
+    for (std::ptrdiff_t j = 0; j < b; ++j) {
+        if (tau[j] == 0)
+            continue;
+        const A* vj = v + j * ldv;
+        for (std::ptrdiff_t i = 0; i < j; ++i) {
+            const A* vi = v + i * ldv;
+            A        s  = 0;
+            if (tau[i] != 0)
+                for (std::ptrdiff_t r = j; r < rows; ++r)
+                    s += vi[r] * vj[r];
+            w[i] = s;}
+        for (std::ptrdiff_t i = 0; i < j; ++i) {
+            A s = 0;
+            for (std::ptrdiff_t l = i; l < j; ++l)
+                s += t[l * b + i] * w[l];
+            t[j * b + i] = -tau[j] * s;}
+        t[j * b + j] = tau[j];}
+
+#ifdef _OPENMP
+    #pragma omp parallel if (std::size_t(rows * cols * b) >= decomposition_grain())
+#endif
+    {
+    std::vector<A> y(b);
+    std::vector<A> z(b);
+#ifdef _OPENMP
+    #pragma omp for schedule(static)
+#endif
+    for (std::ptrdiff_t k = 0; k < cols; ++k) {
+        A* ck = c + k * ldc;
+        for (std::ptrdiff_t j = 0; j < b; ++j) {
+            const A* vj = v + j * ldv;
+            A        s  = 0;
+            if (tau[j] != 0)
+                for (std::ptrdiff_t r = j; r < rows; ++r)
+                    s += vj[r] * ck[r];
+            y[j] = s;}
+        for (std::ptrdiff_t i = 0; i < b; ++i) {
+            A s = 0;
+            for (std::ptrdiff_t j = i; j < b; ++j)
+                s += t[j * b + i] * y[j];
+            z[i] = s;}
+        for (std::ptrdiff_t j = 0; j < b; ++j) {
+            const A* vj = v + j * ldv;
+            const A  zj = z[j];
+            if (tau[j] != 0 && zj != 0)
+                for (std::ptrdiff_t r = j; r < rows; ++r)
+                    ck[r] -= vj[r] * zj;}}
+    }}
+
+// --------------
+// PlaneRotations
+// --------------
+
+/**
+ * A sequence of plane rotations of the columns of a matrix stored by columns:
+ * each replaces a pair of columns (a, b) with (c a - s b, s a + c b).
+ * apply() runs through the whole sequence one block of rows at a time, so each
+ * block stays in cache and the blocks are rotated in parallel.
+ */
+template <typename A>
+class PlaneRotations {
+    private:
+        std::vector<std::ptrdiff_t> _first;
+        std::vector<std::ptrdiff_t> _second;
+        std::vector<A>              _c;
+        std::vector<A>              _s;
+
+    public:
+        void push_back (std::ptrdiff_t first, std::ptrdiff_t second, A c, A s) {
+            _first.push_back(first);
+            _second.push_back(second);
+            _c.push_back(c);
+            _s.push_back(s);}
+
+        /**
+         * Used to rotate x, then forget the rotations.
+         * @param x the matrix, its columns ld apart.
+         * @param rows the number of rows of x.
+         */
+        void apply (A* x, std::ptrdiff_t ld, std::ptrdiff_t rows) {
+            const std::ptrdiff_t count  = _c.size();
+            const std::ptrdiff_t block  = 256;
+            const std::ptrdiff_t blocks = (rows + block - 1) / block;
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(static) if (std::size_t(rows * count) >= decomposition_grain())
+#endif
+            for (std::ptrdiff_t b = 0; b < blocks; ++b) {
+                const std::ptrdiff_t r0 = b * block;
+                const std::ptrdiff_t r1 = std::min(rows, r0 + block);
+                for (std::ptrdiff_t t = 0; t < count; ++t) {
+                    A*      p = x + _first[t]  * ld;
+                    A*      q = x + _second[t] * ld;
+                    const A c = _c[t];
+                    const A s = _s[t];
+                    for (std::ptrdiff_t r = r0; r < r1; ++r) {
+                        const A u = p[r];
+                        const A w = q[r];
+                        p[r] = c * u - s * w;
+                        q[r] = s * u + c * w;}}}
+            _first.clear();
+            _second.clear();
+            _c.clear();
+            _s.clear();}};
+
+// ------------------
+// eig_tridiagonalize
+// ------------------
+
+/**
+ * Used to reduce a symmetric matrix to tridiagonal form by Householder reflections
+ * (EISPACK tred2).
+ * @param v the n x n matrix by columns, of which the lower triangle is read;
+ *          with vectors, it is replaced by the orthogonal transformation.
+ * @param d the n elements of the diagonal.
+ * @param e the n elements of the subdiagonal, in e[1..n-1].
+ * @param vectors whether to form the transformation.
+ */
+template <typename A>
+void eig_tridiagonalize (A* v, std::ptrdiff_t n, A* d, A* e, bool vectors) {
+    for (std::ptrdiff_t j = 0; j < n; ++j)
+        d[j] = v[j * n + n - 1];
+
+    for (std::ptrdiff_t i = n - 1; i > 0; --i) {
+        A scale = 0;
+        A h     = 0;
+        for (std::ptrdiff_t k = 0; k < i; ++k)
+            scale += std::fabs(d[k]);
+        if (scale == 0) {
+            e[i] = d[i - 1];
+            for (std::ptrdiff_t j = 0; j < i; ++j) {
+                d[j]         = v[j * n + i - 1];
+                v[j * n + i] = 0;
+                v[i * n + j] = 0;}}
+        else {
+            for (std::ptrdiff_t k = 0; k < i; ++k) {
+                d[k] /= scale;
+                h    += d[k] * d[k];}
+            A f = d[i - 1];
+            A g = std::sqrt(h);
+            if (f > 0)
+                g = -g;
+            e[i]     = scale * g;
+            h       -= f * g;
+            d[i - 1] = f - g;
+            for (std::ptrdiff_t j = 0; j < i; ++j) {
+                e[j]         = 0;
+                v[i * n + j] = d[j];}
+
+            // e = A d, over the lower triangle; each thread sums into its own copy
+#ifdef _OPENMP
+            #pragma omp parallel if (std::size_t(i * i) >= decomposition_grain())
+#endif
+            {
+            std::vector<A> local(i, A());
+#ifdef _OPENMP
+            #pragma omp for schedule(dynamic, 16) nowait
+#endif
+            for (std::ptrdiff_t j = 0; j < i; ++j) {
+                const A* vj = v + j * n;
+                const A  fj = d[j];
+                A        gj = vj[j] * fj;
+                for (std::ptrdiff_t k = j + 1; k < i; ++k) {
+                    gj       += vj[k] * d[k];
+                    local[k] += vj[k] * fj;}
+                local[j] += gj;}
+#ifdef _OPENMP
+            #pragma omp critical
+#endif
+            for (std::ptrdiff_t k = 0; k < i; ++k)
+                e[k] += local[k];
+            }
+
+            f = 0;
+            for (std::ptrdiff_t j = 0; j < i; ++j) {
+                e[j] /= h;
+                f    += e[j] * d[j];}
+            const A hh = f / (h + h);
+            for (std::ptrdiff_t j = 0; j < i; ++j)
+                e[j] -= hh * d[j];
+
+            // A -= d e' + e d', over the lower triangle
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(dynamic, 16) if (std::size_t(i * i) >= decomposition_grain())
+#endif
+            for (std::ptrdiff_t j = 0; j < i; ++j) {
+                A*      vj = v + j * n;
+                const A fj = d[j];
+                const A gj = e[j];
+                for (std::ptrdiff_t k = j; k < i; ++k)
+                    vj[k] -= fj * e[k] + gj * d[k];}
+            for (std::ptrdiff_t j = 0; j < i; ++j) {
+                d[j]         = v[j * n + i - 1];
+                v[j * n + i] = 0;}}
+        d[i] = h;}
+
+    e[0] = 0;
+    if (!vectors) {
+        for (std::ptrdiff_t j = 0; j < n; ++j)
+            d[j] = v[j * n + j];
+        return;}
+
+    for (std::ptrdiff_t i = 0; i < n - 1; ++i) {
+        A* vi = v + (i + 1) * n;
+        v[i * n + n - 1] = v[i * n + i];
+        v[i * n + i]     = 1;
+        const A h = d[i + 1];
+        if (h != 0) {
+            for (std::ptrdiff_t k = 0; k <= i; ++k)
+                d[k] = vi[k] / h;
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(static) if (std::size_t(i * i) >= decomposition_grain())
+#endif
+            for (std::ptrdiff_t j = 0; j <= i; ++j) {
+                A* vj = v + j * n;
+                A  g  = 0;
+                for (std::ptrdiff_t k = 0; k <= i; ++k)
+                    g += vi[k] * vj[k];
+                for (std::ptrdiff_t k = 0; k <= i; ++k)
+                    vj[k] -= g * d[k];}}
+        for (std::ptrdiff_t k = 0; k <= i; ++k)
+            vi[k] = 0;}
+    for (std::ptrdiff_t j = 0; j < n; ++j) {
+        d[j]             = v[j * n + n - 1];
+        v[j * n + n - 1] = 0;}
+    v[n * n - 1] = 1;}
+
+// ------------------
+// eig_tridiagonal_ql
+// ------------------
+
+/**
+ * Used to find the eigenvalues (and vectors) of a symmetric tridiagonal matrix by
+ * the implicit QL method (EISPACK tql2).
+ * @param v the n x n transformation from eig_tridiagonalize(), by columns;
+ *          with vectors, its columns become the eigenvectors.
+ * @param d the diagonal; becomes the eigenvalues, unordered.
+ * @param e the subdiagonal, in e[1..n-1]; destroyed.
+ * @return false if it did not converge within decomposition_sweeps(n) steps.
+ */
+template <typename A>
+bool eig_tridiagonal_ql (A* v, std::ptrdiff_t n, A* d, A* e, bool vectors) {
+    for (std::ptrdiff_t i = 1; i < n; ++i)
+        e[i - 1] = e[i];
+    e[n - 1] = 0;
+
+    const A           eps  = std::numeric_limits<A>::epsilon();
+    A                 f    = 0;
+    A                 tst1 = 0;
+    std::ptrdiff_t    sweeps = 0;
+    PlaneRotations<A> rotations;
+    for (std::ptrdiff_t l = 0; l < n; ++l) {
+        tst1 = std::max(tst1, A(std::fabs(d[l]) + std::fabs(e[l])));
+        std::ptrdiff_t m = l;
+        while (m < n - 1 && std::fabs(e[m]) > eps * tst1)
+            ++m;
+        if (m > l) {
+            do {
+                if (++sweeps > decomposition_sweeps(n))
+                    return false;
+                A g = d[l];
+                A p = (d[l + 1] - g) / (2 * e[l]);
+                A r = decomposition_hypot(p, A(1));
+                if (p < 0)
+                    r = -r;
+                d[l]     = e[l] / (p + r);
+                d[l + 1] = e[l] * (p + r);
+                const A dl1 = d[l + 1];
+                A h = g - d[l];
+                for (std::ptrdiff_t i = l + 2; i < n; ++i)
+                    d[i] -= h;
+                f += h;
+
+                p = d[m];
+                A c   = 1;
+                A c2  = c;
+                A c3  = c;
+                A s   = 0;
+                A s2  = 0;
+                const A el1 = e[l + 1];
+                for (std::ptrdiff_t i = m - 1; i >= l; --i) {
+                    c3 = c2;
+                    c2 = c;
+                    s2 = s;
+                    g  = c * e[i];
+                    h  = c * p;
+                    r  = decomposition_hypot(p, e[i]);
+                    e[i + 1] = s * r;
+                    s  = e[i] / r;
+                    c  = p / r;
+                    p  = c * d[i] - s * g;
+                    d[i + 1] = h + s * (c * g + s * d[i]);
+                    if (vectors)
+                        rotations.push_back(i, i + 1, c, s);}
+                p    = -s * s2 * c3 * el1 * e[l] / dl1;
+                e[l] = s * p;
+                d[l] = c * p;
+                if (vectors)
+                    rotations.apply(v, n, n);}
+            while (std::fabs(e[l]) > eps * tst1);}
+        d[l] += f;
+        e[l]  = 0;}
+    return true;}
+
+// --------------
+// eig_hessenberg
+// --------------
+
+/**
+ * Used to reduce a square matrix to upper Hessenberg form by Householder
+ * reflections (EISPACK orthes).
+ * @param h the n x n matrix, by rows.
+ */
+template <typename A>
+void eig_hessenberg (A* h, std::ptrdiff_t n) {
+    std::vector<A> ort(n);
+    std::vector<A> f(n);
+    for (std::ptrdiff_t m = 1; m < n - 1; ++m) {
+        A scale = 0;
+        for (std::ptrdiff_t i = m; i < n; ++i)
+            scale += std::fabs(h[i * n + m - 1]);
+        if (scale == 0)
+            continue;
+        A hh = 0;
+        for (std::ptrdiff_t i = n - 1; i >= m; --i) {
+            ort[i] = h[i * n + m - 1] / scale;
+            hh    += ort[i] * ort[i];}
+        A g = std::sqrt(hh);
+        if (ort[m] > 0)
+            g = -g;
+        hh     -= ort[m] * g;
+        ort[m] -= g;
+
+        // H = (I - u u' / hh) H, a row at a time
+        for (std::ptrdiff_t j = m; j < n; ++j)
+            f[j] = 0;
+        for (std::ptrdiff_t i = m; i < n; ++i) {
+            const A* hi = h + i * n;
+            for (std::ptrdiff_t j = m; j < n; ++j)
+                f[j] += ort[i] * hi[j];}
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static) if (std::size_t((n - m) * (n - m)) >= decomposition_grain())
+#endif
+        for (std::ptrdiff_t i = m; i < n; ++i) {
+            A*      hi = h + i * n;
+            const A oi = ort[i] / hh;
+            for (std::ptrdiff_t j = m; j < n; ++j)
+                hi[j] -= f[j] * oi;}
+
+        // H = H (I - u u' / hh)
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static) if (std::size_t(n * (n - m)) >= decomposition_grain())
+#endif
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+            A* hi = h + i * n;
+            A  fi = 0;
+            for (std::ptrdiff_t j = m; j < n; ++j)
+                fi += ort[j] * hi[j];
+            fi /= hh;
+            for (std::ptrdiff_t j = m; j < n; ++j)
+                hi[j] -= fi * ort[j];}
+
+        for (std::ptrdiff_t i = m + 1; i < n; ++i)
+            h[i * n + m - 1] = 0;
+        h[m * n + m - 1] = scale * g;}}
+
+// ------------
+// RowMajorView
+// ------------
+
+/**
+ * An n x n matrix stored by rows, indexed as h(i, j).
+ */
+template <typename A>
+class RowMajorView {
+    private:
+        A*             _h;
+        std::ptrdiff_t _n;
+
+    public:
+        RowMajorView (A* h, std::ptrdiff_t n) : _h(h), _n(n) {}
+
+        A& operator () (std::ptrdiff_t i, std::ptrdiff_t j) const {
+            return _h[i * _n + j];}};
+
+// -----------------
+// eig_hessenberg_qr
+// -----------------
+
+/**
+ * Used to find the eigenvalues of an upper Hessenberg matrix by the shifted
+ * double-step QR method (EISPACK hqr). Complex conjugate pairs come out together,
+ * the one with the positive imaginary part first.
+ * @param h the n x n matrix, by rows; destroyed.
+ * @param wr the n real parts.
+ * @param wi the n imaginary parts.
+ * @return false if it did not converge within decomposition_sweeps(n) steps.
+ */
+template <typename A>
+bool eig_hessenberg_qr (A* h, std::ptrdiff_t nn, A* wr, A* wi) {
+    const RowMajorView<A> H(h, nn);
+    const A eps     = std::numeric_limits<A>::epsilon();
+    A       exshift = 0;
+    A       p = 0, q = 0, r = 0, s = 0, z = 0, t, w, x, y;
+
+    A norm = 0;
+    for (std::ptrdiff_t i = 0; i < nn; ++i)
+        for (std::ptrdiff_t j = std::max(i - 1, std::ptrdiff_t(0)); j < nn; ++j)
+            norm += std::fabs(H(i, j));
+
+    std::ptrdiff_t n      = nn - 1;
+    int            iter   = 0;
+    std::ptrdiff_t sweeps = 0;
+    while (n >= 0) {
+        // look for a single small subdiagonal element
+        std::ptrdiff_t l = n;
+        while (l > 0) {
+            s = std::fabs(H(l - 1, l - 1)) + std::fabs(H(l, l));
+            if (s == 0)
+                s = norm;
+            if (std::fabs(H(l, l - 1)) < eps * s)
+                break;
+            --l;}
+
+        if (l == n) {
+            // one root
+            wr[n] = H(n, n) + exshift;
+            wi[n] = 0;
+            --n;
+            iter = 0;}
+        else if (l == n - 1) {
+            // two roots
+            w = H(n, n - 1) * H(n - 1, n);
+            p = (H(n - 1, n - 1) - H(n, n)) / 2;
+            q = p * p + w;
+            z = std::sqrt(std::fabs(q));
+            x = H(n, n) + exshift;
+            if (q >= 0) {
+                z = p >= 0 ? p + z : p - z;
+                wr[n - 1] = x + z;
+                wr[n]     = z != 0 ? x - w / z : x + z;
+                wi[n - 1] = 0;
+                wi[n]     = 0;}
+            else {
+                wr[n - 1] = x + p;
+                wr[n]     = x + p;
+                wi[n - 1] = z;
+                wi[n]     = -z;}
+            n   -= 2;
+            iter = 0;}
+        else {
+            // no convergence yet: form the shift
+            if (++sweeps > decomposition_sweeps(nn))
+                return false;
+            x = H(n, n);
+            y = H(n - 1, n - 1);
+            w = H(n, n - 1) * H(n - 1, n);
+            if (iter == 10) {
+                // Wilkinson's exceptional shift
+                exshift += x;
+                for (std::ptrdiff_t i = 0; i <= n; ++i)
+                    H(i, i) -= x;
+                s = std::fabs(H(n, n - 1)) + std::fabs(H(n - 1, n - 2));
+                x = y = A(0.75) * s;
+                w = A(-0.4375) * s * s;}
+            if (iter == 30) {
+                // MATLAB's exceptional shift
+                s = (y - x) / 2;
+                s = s * s + w;
+                if (s > 0) {
+                    s = std::sqrt(s);
+                    if (y < x)
+                        s = -s;
+                    s = x - w / ((y - x) / 2 + s);
+                    for (std::ptrdiff_t i = 0; i <= n; ++i)
+                        H(i, i) -= s;
+                    exshift += s;
+                    x = y = w = A(0.964);}}
+            ++iter;
+
+            // look for two consecutive small subdiagonal elements
+            std::ptrdiff_t m = n - 2;
+            while (m >= l) {
+                z = H(m, m);
+                r = x - z;
+                s = y - z;
+                p = (r * s - w) / H(m + 1, m) + H(m, m + 1);
+                q = H(m + 1, m + 1) - z - r - s;
+                r = H(m + 2, m + 1);
+                s = std::fabs(p) + std::fabs(q) + std::fabs(r);
+                p /= s;
+                q /= s;
+                r /= s;
+                if (m == l)
+                    break;
+                if (std::fabs(H(m, m - 1)) * (std::fabs(q) + std::fabs(r)) <
+                    eps * (std::fabs(p) * (std::fabs(H(m - 1, m - 1)) + std::fabs(z) + std::fabs(H(m + 1, m + 1)))))
+                    break;
+                --m;}
+            for (std::ptrdiff_t i = m + 2; i <= n; ++i) {
+                H(i, i - 2) = 0;
+                if (i > m + 2)
+                    H(i, i - 3) = 0;}
+
+            // double QR step on rows l..n and columns m..n
+            for (std::ptrdiff_t k = m; k <= n - 1; ++k) {
+                const bool notlast = k != n - 1;
+                if (k != m) {
+                    p = H(k, k - 1);
+                    q = H(k + 1, k - 1);
+                    r = notlast ? H(k + 2, k - 1) : A(0);
+                    x = std::fabs(p) + std::fabs(q) + std::fabs(r);
+                    if (x == 0)
+                        continue;
+                    p /= x;
+                    q /= x;
+                    r /= x;}
+                s = std::sqrt(p * p + q * q + r * r);
+                if (p < 0)
+                    s = -s;
+                if (s == 0)
+                    continue;
+                if (k != m)
+                    H(k, k - 1) = -s * x;
+                else if (l != m)
+                    H(k, k - 1) = -H(k, k - 1);
+                p += s;
+                x  = p / s;
+                y  = q / s;
+                z  = r / s;
+                q /= p;
+                r /= p;
+                for (std::ptrdiff_t j = k; j < nn; ++j) {
+                    t = H(k, j) + q * H(k + 1, j);
+                    if (notlast) {
+                        t           += r * H(k + 2, j);
+                        H(k + 2, j) -= t * z;}
+                    H(k, j)     -= t * x;
+                    H(k + 1, j) -= t * y;}
+                for (std::ptrdiff_t i = 0; i <= std::min(n, k + 3); ++i) {
+                    t = x * H(i, k) + y * H(i, k + 1);
+                    if (notlast) {
+                        t           += z * H(i, k + 2);
+                        H(i, k + 2) -= t * r;}
+                    H(i, k)     -= t;
+                    H(i, k + 1) -= t * q;}}}}
+    return true;}
+
+// ---------------
+// svd_golub_kahan
+// ---------------
+
+/**
+ * Used to decompose an m x n matrix, m >= n, into u diag(s) v' (after LINPACK dsvdc).
+ * @param a the matrix, by columns; destroyed.
+ * @param s the n singular values, in descending order.
+ * @param u 0, or the m x n left singular vectors, by columns.
+ * @param v 0, or the n x n right singular vectors, by columns.
+ * @return false if it did not converge within decomposition_sweeps(n) QR steps.
+ */
+template <typename A>
+bool svd_golub_kahan (A* a, std::ptrdiff_t m, std::ptrdiff_t n, A* s, A* u, A* v) {
+    std::vector<A> e(n);
+    std::vector<A> work(m);
+
+    // reduce a to bidiagonal form, with the diagonal in s and the superdiagonal in e
+    const std::ptrdiff_t nct = std::min(m - 1, n);
+    const std::ptrdiff_t nrt = std::max(std::ptrdiff_t(0), std::min(n - 2, m));
+    for (std::ptrdiff_t k = 0; k < std::max(nct, nrt); ++k) {
+        A* ak = a + k * m;
+        if (k < nct) {
+            s[k] = decomposition_norm(ak + k, m - k);
+            if (s[k] != 0) {
+                if (ak[k] < 0)
+                    s[k] = -s[k];
+                for (std::ptrdiff_t i = k; i < m; ++i)
+                    ak[i] /= s[k];
+                ak[k] += 1;}
+            s[k] = -s[k];}
+        const bool reflect = k < nct && s[k] != 0;
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static) if (std::size_t((m - k) * (n - k)) >= decomposition_grain())
+#endif
+        for (std::ptrdiff_t j = k + 1; j < n; ++j) {
+            A* aj = a + j * m;
+            if (reflect) {
+                A t = 0;
+                for (std::ptrdiff_t i = k; i < m; ++i)
+                    t += ak[i] * aj[i];
+                t = -t / ak[k];
+                for (std::ptrdiff_t i = k; i < m; ++i)
+                    aj[i] += t * ak[i];}
+            e[j] = aj[k];}
+        if (u && k < nct)
+            for (std::ptrdiff_t i = k; i < m; ++i)
+                u[k * m + i] = ak[i];
+        if (k < nrt) {
+            e[k] = decomposition_norm(&e[k + 1], n - k - 1);
+            if (e[k] != 0) {
+                if (e[k + 1] < 0)
+                    e[k] = -e[k];
+                for (std::ptrdiff_t i = k + 1; i < n; ++i)
+                    e[i] /= e[k];
+                e[k + 1] += 1;}
+            e[k] = -e[k];
+            if (k + 1 < m && e[k] != 0) {
+                const std::ptrdiff_t block  = 256;
+                const std::ptrdiff_t blocks = (m - k - 1 + block - 1) / block;
+#ifdef _OPENMP
+                #pragma omp parallel for schedule(static) if (std::size_t((m - k) * (n - k)) >= decomposition_grain())
+#endif
+                for (std::ptrdiff_t b = 0; b < blocks; ++b) {
+                    const std::ptrdiff_t i0 = k + 1 + b * block;
+                    const std::ptrdiff_t i1 = std::min(m, i0 + block);
+                    for (std::ptrdiff_t i = i0; i < i1; ++i)
+                        work[i] = 0;
+                    for (std::ptrdiff_t j = k + 1; j < n; ++j) {
+                        const A* aj = a + j * m;
+                        for (std::ptrdiff_t i = i0; i < i1; ++i)
+                            work[i] += e[j] * aj[i];}}
+#ifdef _OPENMP
+                #pragma omp parallel for schedule(static) if (std::size_t((m - k) * (n - k)) >= decomposition_grain())
+#endif
+                for (std::ptrdiff_t j = k + 1; j < n; ++j) {
+                    A*      aj = a + j * m;
+                    const A t  = -e[j] / e[k + 1];
+                    for (std::ptrdiff_t i = k + 1; i < m; ++i)
+                        aj[i] += t * work[i];}}
+            if (v)
+                for (std::ptrdiff_t i = k + 1; i < n; ++i)
+                    v[k * n + i] = e[i];}}
+
+    std::ptrdiff_t p = n;
+    if (nct < n)
+        s[nct] = a[nct * m + nct];
+    if (nrt + 1 < p)
+        e[nrt] = a[(p - 1) * m + nrt];
+    e[p - 1] = 0;
+
+    // form u and v from the reflections, a panel at a time: the panel's reflections
+    // go to the columns after it in compact WY form, then one by one to its own
+    const std::ptrdiff_t panel = decomposition_panel();
+    std::vector<A>       tau(panel);
+    if (u) {
+        for (std::ptrdiff_t j = nct; j < n; ++j) {
+            for (std::ptrdiff_t i = 0; i < m; ++i)
+                u[j * m + i] = 0;
+            u[j * m + j] = 1;}
+        for (std::ptrdiff_t k1 = nct; k1 > 0; k1 -= panel) {
+            const std::ptrdiff_t k0 = std::max(std::ptrdiff_t(0), k1 - panel);
+            for (std::ptrdiff_t k = k0; k < k1; ++k)
+                tau[k - k0] = s[k] != 0 ? 1 / u[k * m + k] : A(0);
+            householder_block_reflect(u + k0 * m + k0, m, &tau[0], k1 - k0, u + k1 * m + k0, m, m - k0, n - k1);
+            for (std::ptrdiff_t k = k1 - 1; k >= k0; --k) {
+                A* uk = u + k * m;
+                if (s[k] != 0) {
+                    for (std::ptrdiff_t j = k + 1; j < k1; ++j) {
+                        A* uj = u + j * m;
+                        A  t  = 0;
+                        for (std::ptrdiff_t i = k; i < m; ++i)
+                            t += uk[i] * uj[i];
+                        t = -t / uk[k];
+                        for (std::ptrdiff_t i = k; i < m; ++i)
+                            uj[i] += t * uk[i];}
+                    for (std::ptrdiff_t i = k; i < m; ++i)
+                        uk[i] = -uk[i];
+                    uk[k] += 1;
+                    for (std::ptrdiff_t i = 0; i < k; ++i)
+                        uk[i] = 0;}
+                else {
+                    for (std::ptrdiff_t i = 0; i < m; ++i)
+                        uk[i] = 0;
+                    uk[k] = 1;}}}}
+    if (v) {
+        for (std::ptrdiff_t k = n - 1; k >= nrt; --k) {
+            std::fill(v + k * n, v + (k + 1) * n, A());
+            v[k * n + k] = 1;}
+        for (std::ptrdiff_t k1 = nrt; k1 > 0; k1 -= panel) {
+            const std::ptrdiff_t k0 = std::max(std::ptrdiff_t(0), k1 - panel);
+            for (std::ptrdiff_t k = k0; k < k1; ++k)
+                tau[k - k0] = e[k] != 0 ? 1 / v[k * n + k + 1] : A(0);
+            householder_block_reflect(v + k0 * n + k0 + 1, n, &tau[0], k1 - k0, v + k1 * n + k0 + 1, n, n - k0 - 1, n - k1);
+            for (std::ptrdiff_t k = k1 - 1; k >= k0; --k) {
+                A* vk = v + k * n;
+                if (e[k] != 0)
+                    for (std::ptrdiff_t j = k + 1; j < k1; ++j) {
+                        A* vj = v + j * n;
+                        A  t  = 0;
+                        for (std::ptrdiff_t i = k + 1; i < n; ++i)
+                            t += vk[i] * vj[i];
+                        t = -t / vk[k + 1];
+                        for (std::ptrdiff_t i = k + 1; i < n; ++i)
+                            vj[i] += t * vk[i];}
+                std::fill(vk, vk + n, A());
+                vk[k] = 1;}}}
+
+    // diagonalize the bidiagonal form
+    const A           eps  = std::numeric_limits<A>::epsilon();
+    const A           tiny = std::numeric_limits<A>::min() / eps;
+    const std::ptrdiff_t pp = p - 1;
+    PlaneRotations<A> left;
+    PlaneRotations<A> right;
+    std::ptrdiff_t    sweeps = 0;
+    while (p > 0) {
+        // find the negligible elements: kase 1 if s[p - 1] is, 2 if s[k] is,
+        // 3 if e[k - 1] is (take a QR step), 4 if e[p - 2] is (s[p - 1] converged)
+        std::ptrdiff_t k;
+        for (k = p - 2; k >= 0; --k)
+            if (std::fabs(e[k]) <= tiny + eps * (std::fabs(s[k]) + std::fabs(s[k + 1]))) {
+                e[k] = 0;
+                break;}
+        int kase;
+        if (k == p - 2)
+            kase = 4;
+        else {
+            std::ptrdiff_t ks;
+            for (ks = p - 1; ks > k; --ks) {
+                const A t = (ks != p ? std::fabs(e[ks]) : A(0)) + (ks != k + 1 ? std::fabs(e[ks - 1]) : A(0));
+                if (std::fabs(s[ks]) <= tiny + eps * t) {
+                    s[ks] = 0;
+                    break;}}
+            if (ks == k)
+                kase = 3;
+            else if (ks == p - 1)
+                kase = 1;
+            else {
+                kase = 2;
+                k    = ks;}}
+        ++k;
+
+        switch (kase) {
+            case 1: {
+                // deflate a negligible s[p - 1]
+                A f = e[p - 2];
+                e[p - 2] = 0;
+                for (std::ptrdiff_t j = p - 2; j >= k; --j) {
+                    const A t  = decomposition_hypot(s[j], f);
+                    const A cs = s[j] / t;
+                    const A sn = f / t;
+                    s[j] = t;
+                    if (j != k) {
+                        f        = -sn * e[j - 1];
+                        e[j - 1] =  cs * e[j - 1];}
+                    if (v)
+                        right.push_back(j, p - 1, cs, -sn);}
+                if (v)
+                    right.apply(v, n, n);}
+                break;
+
+            case 2: {
+                // split at a negligible s[k - 1]
+                A f = e[k - 1];
+                e[k - 1] = 0;
+                for (std::ptrdiff_t j = k; j < p; ++j) {
+                    const A t  = decomposition_hypot(s[j], f);
+                    const A cs = s[j] / t;
+                    const A sn = f / t;
+                    s[j] = t;
+                    f    = -sn * e[j];
+                    e[j] =  cs * e[j];
+                    if (u)
+                        left.push_back(j, k - 1, cs, -sn);}
+                if (u)
+                    left.apply(u, m, m);}
+                break;
+
+            case 3: {
+                // one QR step, with the shift from the trailing 2 x 2 block
+                if (++sweeps > decomposition_sweeps(n))
+                    return false;
+                const A scale = std::max(std::max(std::max(std::max(std::fabs(s[p - 1]), std::fabs(s[p - 2])),
+                                                           std::fabs(e[p - 2])), std::fabs(s[k])), std::fabs(e[k]));
+                const A sp    = s[p - 1] / scale;
+                const A spm1  = s[p - 2] / scale;
+                const A epm1  = e[p - 2] / scale;
+                const A sk    = s[k] / scale;
+                const A ek    = e[k] / scale;
+                const A b     = ((spm1 + sp) * (spm1 - sp) + epm1 * epm1) / 2;
+                const A c     = (sp * epm1) * (sp * epm1);
+                A shift = 0;
+                if (b != 0 || c != 0) {
+                    shift = std::sqrt(b * b + c);
+                    if (b < 0)
+                        shift = -shift;
+                    shift = c / (b + shift);}
+                A f = (sk + sp) * (sk - sp) + shift;
+                A g = sk * ek;
+                for (std::ptrdiff_t j = k; j < p - 1; ++j) {
+                    A t  = decomposition_hypot(f, g);
+                    A cs = f / t;
+                    A sn = g / t;
+                    if (j != k)
+                        e[j - 1] = t;
+                    f        = cs * s[j] + sn * e[j];
+                    e[j]     = cs * e[j] - sn * s[j];
+                    g        = sn * s[j + 1];
+                    s[j + 1] = cs * s[j + 1];
+                    if (v)
+                        right.push_back(j, j + 1, cs, -sn);
+                    t  = decomposition_hypot(f, g);
+                    cs = f / t;
+                    sn = g / t;
+                    s[j]     = t;
+                    f        =  cs * e[j] + sn * s[j + 1];
+                    s[j + 1] = -sn * e[j] + cs * s[j + 1];
+                    g        = sn * e[j + 1];
+                    e[j + 1] = cs * e[j + 1];
+                    if (u)
+                        left.push_back(j, j + 1, cs, -sn);}
+                e[p - 2] = f;
+                if (v)
+                    right.apply(v, n, n);
+                if (u)
+                    left.apply(u, m, m);}
+                break;
+
+            case 4: {
+                // convergence: make s[k] positive, then move it into order
+                if (s[k] <= 0) {
+                    s[k] = s[k] < 0 ? -s[k] : A(0);
+                    if (v)
+                        for (std::ptrdiff_t i = 0; i <= pp; ++i)
+                            v[k * n + i] = -v[k * n + i];}
+                while (k < pp && s[k] < s[k + 1]) {
+                    std::swap(s[k], s[k + 1]);
+                    if (v)
+                        std::swap_ranges(v + k * n, v + (k + 1) * n, v + (k + 1) * n);
+                    if (u)
+                        std::swap_ranges(u + k * m, u + (k + 1) * m, u + (k + 1) * m);
+                    ++k;}
+                --p;}
+                break;}}
+    return true;}
+
+// ----------------
+// decomposition_in
+// ----------------
+
+/**
+ * Used to copy x into a, by columns (or, transposed, by rows).
+ */
+template <typename T, typename A>
+void decomposition_in (const T& x, A* a, bool transposed) {
+    const std::ptrdiff_t m = x.size();
+    const std::ptrdiff_t n = x.columns();
+    for (std::ptrdiff_t i = 0; i < m; ++i)
+        for (std::ptrdiff_t j = 0; j < n; ++j)
+            a[transposed ? i * n + j : j * m + i] = A(x[i][j]);}
+
+// -----------------
+// decomposition_out
+// -----------------
+
+/**
+ * @param a an r x c matrix, its columns ld apart (or, transposed, its rows).
+ * @return a as a Matrix.
+ */
+template <typename T, typename A>
+T decomposition_out (const A* a, std::ptrdiff_t ld, std::ptrdiff_t r, std::ptrdiff_t c, bool transposed) {
+    typedef typename T::element_type E;
+    T result(r, c, 0);
+    for (std::ptrdiff_t i = 0; i < r; ++i)
+        for (std::ptrdiff_t j = 0; j < c; ++j)
+            result[i][j] = E(transposed ? a[i * ld + j] : a[j * ld + i]);
+    return result;}
+
+// ------------------
+// decomposition_diag
+// ------------------
+
+/**
+ * @return the k x k matrix with the k elements at s on its diagonal.
+ */
+template <typename T, typename A>
+T decomposition_diag (const A* s, std::ptrdiff_t k) {
+    typedef typename T::element_type E;
+    T result(k, k, 0);
+    for (std::ptrdiff_t i = 0; i < k; ++i)
+        result[i][i] = E(s[i]);
+    return result;}
+
+// -------------
+// eig_symmetric
+// -------------
+
+/**
+ * Used to find the eigenvalues, in ascending order, and optionally the
+ * eigenvectors, by columns, of the symmetric matrix x.
+ */
+template <typename T, typename A>
+void eig_symmetric (const T& x, std::vector<A>& d, std::vector<A>* v) {
+    const std::ptrdiff_t n = x.size();
+    std::vector<A> w(n * n);
+    std::vector<A> e(n);
+    d.resize(n);
+    decomposition_in(x, &w[0], false);
+    for (std::ptrdiff_t j = 0; j < n; ++j)
+        if (!decomposition_finite(&w[j * n + j], n - j))
+            throw ConvergenceException("eig");
+    eig_tridiagonalize(&w[0], n, &d[0], &e[0], v != 0);
+    if (!eig_tridiagonal_ql(&w[0], n, &d[0], &e[0], v != 0))
+        throw ConvergenceException("eig");
+    if (v == 0) {
+        std::sort(d.begin(), d.end());
+        return;}
+    for (std::ptrdiff_t i = 0; i < n - 1; ++i) {
+        std::ptrdiff_t k = i;
+        for (std::ptrdiff_t j = i + 1; j < n; ++j)
+            if (d[j] < d[k])
+                k = j;
+        if (k != i) {
+            std::swap(d[i], d[k]);
+            std::swap_ranges(&w[i * n], &w[i * n] + n, &w[k * n]);}}
+    v->swap(w);}
+
+// ---
+// eig
+// ---
+
+/**
+ * Used to find the eigenvalues of a symmetric matrix.
+ * - the matrix must be square, must not be empty.
+ * - only the lower triangle is read; the matrix is taken to be symmetric.
+ * - the elements must be of a floating-point type.
+ * @param x the matrix.
+ * @return a new n x 1 matrix of the eigenvalues, in ascending order.
+ * Reference: http://www.mathworks.com/help/matlab/ref/eig.html
+ */
+template <typename T>
+T eig (const T& x) {
+    typedef typename T::element_type                     E;
+    typedef typename numeric_traits<E>::accumulate_type  A;
+    typedef typename T::check_type                       C;
+    (void) sizeof(char[numeric_traits<E>::floating ? 1 : -1]); // eig needs floating-point elements
+    if (C::enabled && (x.size() == 0 || x.size() != x.columns())) {
+        C::mismatch("eig", x.size(), x.columns());
+        return T();}
+    MATRIX_PROFILE_SCOPE("eig", x.size() * x.size());
+    std::vector<A> d;
+    eig_symmetric(x, d, static_cast<std::vector<A>*>(0));
+    return decomposition_out<T>(&d[0], d.size(), d.size(), 1, false);}
+
+/**
+ * Used to find the eigenvalues and eigenvectors of a symmetric matrix, x v = v d.
+ * - the matrix must be square, must not be empty.
+ * - only the lower triangle is read; the matrix is taken to be symmetric.
+ * - the elements must be of a floating-point type.
+ * @param x the matrix.
+ * @param v set to the n x n matrix of the orthonormal eigenvectors, by columns.
+ * @param d set to the n x n diagonal matrix of the eigenvalues, in ascending order.
+ * Reference: http://www.mathworks.com/help/matlab/ref/eig.html
+ */
+template <typename T>
+void eig (const T& x, T& v, T& d) {
+    typedef typename T::element_type                     E;
+    typedef typename numeric_traits<E>::accumulate_type  A;
+    typedef typename T::check_type                       C;
+    (void) sizeof(char[numeric_traits<E>::floating ? 1 : -1]); // eig needs floating-point elements
+    if (C::enabled && (x.size() == 0 || x.size() != x.columns())) {
+        C::mismatch("eig", x.size(), x.columns());
+        v = d = T();
+        return;}
+    MATRIX_PROFILE_SCOPE("eig", x.size() * x.size());
+    const std::ptrdiff_t n = x.size();
+    std::vector<A> w;
+    std::vector<A> values;
+    eig_symmetric(x, values, &w);
+    v = decomposition_out<T>(&w[0], n, n, n, false);
+    d = decomposition_diag<T>(&values[0], n);}
+
+// -----------
+// eig_general
+// -----------
+
+/**
+ * Used to find the eigenvalues of a general, not necessarily symmetric, matrix.
+ * - the matrix must be square, must not be empty.
+ * - the elements must be of a floating-point type.
+ * @param x the matrix.
+ * @param wr set to the n x 1 matrix of the real parts of the eigenvalues.
+ * @param wi set to the n x 1 matrix of their imaginary parts; complex conjugate
+ *           pairs are adjacent, the one with the positive imaginary part first.
+ * Reference: http://www.mathworks.com/help/matlab/ref/eig.html
+ */
+template <typename T>
+void eig_general (const T& x, T& wr, T& wi) {
+    typedef typename T::element_type                     E;
+    typedef typename numeric_traits<E>::accumulate_type  A;
+    typedef typename T::check_type                       C;
+    (void) sizeof(char[numeric_traits<E>::floating ? 1 : -1]); // eig_general needs floating-point elements
+    if (C::enabled && (x.size() == 0 || x.size() != x.columns())) {
+        C::mismatch("eig_general", x.size(), x.columns());
+        wr = wi = T();
+        return;}
+    MATRIX_PROFILE_SCOPE("eig_general", x.size() * x.size());
+    const std::ptrdiff_t n = x.size();
+    std::vector<A> h(n * n);
+    std::vector<A> re(n);
+    std::vector<A> im(n);
+    decomposition_in(x, &h[0], true);
+    if (!decomposition_finite(&h[0], n * n))
+        throw ConvergenceException("eig_general");
+    eig_hessenberg(&h[0], n);
+    if (!eig_hessenberg_qr(&h[0], n, &re[0], &im[0]))
+        throw ConvergenceException("eig_general");
+    wr = decomposition_out<T>(&re[0], n, n, 1, false);
+    wi = decomposition_out<T>(&im[0], n, n, 1, false);}
+
+// ---
+// svd
+// ---
+
+/**
+ * Used to find the singular values of a matrix.
+ * - the matrix must not be empty.
+ * - the elements must be of a floating-point type.
+ * @param x the m x n matrix.
+ * @return a new min(m, n) x 1 matrix of the singular values, in descending order.
+ * Reference: http://www.mathworks.com/help/matlab/ref/svd.html
+ */
+template <typename T>
+T svd (const T& x) {
+    typedef typename T::element_type                     E;
+    typedef typename numeric_traits<E>::accumulate_type  A;
+    typedef typename T::check_type                       C;
+    (void) sizeof(char[numeric_traits<E>::floating ? 1 : -1]); // svd needs floating-point elements
+    if (C::enabled && (x.size() == 0 || x.columns() == 0)) {
+        C::mismatch("svd", x.size(), x.columns());
+        return T();}
+    MATRIX_PROFILE_SCOPE("svd", x.size() * x.columns());
+    const bool           wide = x.size() < x.columns();
+    const std::ptrdiff_t m    = wide ? x.columns() : x.size();
+    const std::ptrdiff_t n    = wide ? x.size()    : x.columns();
+    std::vector<A> a(m * n);
+    std::vector<A> s(n);
+    decomposition_in(x, &a[0], wide);
+    if (!decomposition_finite(&a[0], m * n) || !svd_golub_kahan(&a[0], m, n, &s[0], static_cast<A*>(0), static_cast<A*>(0)))
+        throw ConvergenceException("svd");
+    return decomposition_out<T>(&s[0], n, n, 1, false);}
+
+/**
+ * Used to decompose a matrix, x = u s v' (the economy-size decomposition).
+ * - the matrix must not be empty.
+ * - the elements must be of a floating-point type.
+ * @param x the m x n matrix; let k = min(m, n).
+ * @param u set to the m x k matrix of the left singular vectors, by columns.
+ * @param s set to the k x k diagonal matrix of the singular values, in descending order.
+ * @param v set to the n x k matrix of the right singular vectors, by columns.
+ * Reference: http://www.mathworks.com/help/matlab/ref/svd.html
+ */
+template <typename T>
+void svd (const T& x, T& u, T& s, T& v) {
+    typedef typename T::element_type                     E;
+    typedef typename numeric_traits<E>::accumulate_type  A;
+    typedef typename T::check_type                       C;
+    (void) sizeof(char[numeric_traits<E>::floating ? 1 : -1]); // svd needs floating-point elements
+    if (C::enabled && (x.size() == 0 || x.columns() == 0)) {
+        C::mismatch("svd", x.size(), x.columns());
+        u = s = v = T();
+        return;}
+    MATRIX_PROFILE_SCOPE("svd", x.size() * x.columns());
+    // a wide x is decomposed as x' = v s u'
+    const bool           wide = x.size() < x.columns();
+    const std::ptrdiff_t m    = wide ? x.columns() : x.size();
+    const std::ptrdiff_t n    = wide ? x.size()    : x.columns();
+    std::vector<A> a(m * n);
+    std::vector<A> values(n);
+    std::vector<A> left(m * n);
+    std::vector<A> right(n * n);
+    decomposition_in(x, &a[0], wide);
+    if (!decomposition_finite(&a[0], m * n) || !svd_golub_kahan(&a[0], m, n, &values[0], &left[0], &right[0]))
+        throw ConvergenceException("svd");
+    u = decomposition_out<T>(wide ? &right[0] : &left[0], wide ? n : m, x.size(), n, false);
+    v = decomposition_out<T>(wide ? &left[0] : &right[0], wide ? m : n, x.columns(), n, false);
+    s = decomposition_diag<T>(&values[0], n);}
+
+// -------------------
+// svds_orthonormalize
+// -------------------
+
+/**
+ * Used to orthonormalize the l <= m columns of the m x l matrix q, by modified
+ * Gram-Schmidt applied twice. A column that depends on the ones before it is
+ * replaced by the first unit vector that does not, so q stays orthonormal even
+ * when x has a rank below l.
+ */
+template <typename A>
+void svds_orthonormalize (A* q, std::ptrdiff_t m, std::ptrdiff_t l) {
+    std::ptrdiff_t unit = 0;
+    for (std::ptrdiff_t c = 0; c < l; ++c) {
+        A* qc = q + c * m;
+        for (;;) {
+            const A start = decomposition_norm(qc, m);
+            for (int pass = 0; pass < 2; ++pass)
+                for (std::ptrdiff_t b = 0; b < c; ++b) {
+                    const A* qb = q + b * m;
+                    A        t  = 0;
+                    for (std::ptrdiff_t i = 0; i < m; ++i)
+                        t += qb[i] * qc[i];
+                    for (std::ptrdiff_t i = 0; i < m; ++i)
+                        qc[i] -= t * qb[i];}
+            const A norm = decomposition_norm(qc, m);
+            if (norm > std::sqrt(std::numeric_limits<A>::epsilon()) * start || unit == m) {
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    qc[i] /= norm;
+                break;}
+            std::fill(qc, qc + m, A());
+            qc[unit++] = 1;}}}
+
+// ----
+// svds
+// ----
+
+/**
+ * Used to find the k largest singular values and their vectors, x ~ u s v', by a
+ * randomized range finder: x is multiplied by a random n x (k + oversample) matrix,
+ * the product is refined by power iterations and orthonormalized to q, and the
+ * small matrix q' x is decomposed by svd(). Costs O(m n (k + oversample)) per
+ * iteration instead of O(m n min(m, n)); the error is close to the (k + 1)st
+ * singular value, and the power iterations sharpen it when the singular values
+ * decay slowly. The random matrix has a fixed seed, so results are reproducible.
+ * - the matrix must not be empty.
+ * - k must be positive and at most min(m, n).
+ * - the elements must be of a floating-point type.
+ * @param x the m x n matrix.
+ * @param k the number of singular triplets.
+ * @param u set to the m x k matrix of the left singular vectors, by columns.
+ * @param s set to the k x k diagonal matrix of the singular values, in descending order.
+ * @param v set to the n x k matrix of the right singular vectors, by columns.
+ * @param oversample the number of extra random vectors (10 by default).
+ * @param iterations the number of power iterations (2 by default).
+ * Reference: http://www.mathworks.com/help/matlab/ref/svds.html
+ */
+template <typename T>
+void svds (const T& x, std::size_t k, T& u, T& s, T& v, std::size_t oversample = 10, std::size_t iterations = 2) {
+    typedef typename T::element_type                     E;
+    typedef typename numeric_traits<E>::accumulate_type  A;
+    typedef typename T::check_type                       C;
+    (void) sizeof(char[numeric_traits<E>::floating ? 1 : -1]); // svds needs floating-point elements
+    if (C::enabled && (x.size() == 0 || x.columns() == 0 || k == 0 || k > std::min(x.size(), x.columns()))) {
+        C::mismatch("svds", x.size(), x.columns(), k, k);
+        u = s = v = T();
+        return;}
+    MATRIX_PROFILE_SCOPE("svds", x.size() * x.columns());
+    const std::ptrdiff_t m = x.size();
+    const std::ptrdiff_t n = x.columns();
+    const std::ptrdiff_t l = std::min(k + oversample, std::min(x.size(), x.columns()));
+    std::vector<A> a(m * n);
+    std::vector<A> q(m * l);
+    std::vector<A> z(n * l);
+    decomposition_in(x, &a[0], false);
+    if (!decomposition_finite(&a[0], m * n))
+        throw ConvergenceException("svds");
+
+    unsigned int seed = 2463534242u;
+    for (std::ptrdiff_t i = 0; i < n * l; ++i) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        z[i] = A(seed & 0xffffffu) / A(0x800000) - 1;}
+
+    // q = orth(x z), then z = orth(x' q), q = orth(x z) for each power iteration
+    for (std::size_t it = 0; ; ++it) {
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static) if (std::size_t(m * n * l) >= decomposition_grain())
+#endif
+        for (std::ptrdiff_t c = 0; c < l; ++c) {
+            A*       qc = &q[c * m];
+            const A* zc = &z[c * n];
+            std::fill(qc, qc + m, A());
+            for (std::ptrdiff_t j = 0; j < n; ++j) {
+                const A* aj = &a[j * m];
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    qc[i] += aj[i] * zc[j];}}
+        svds_orthonormalize(&q[0], m, l);
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static) if (std::size_t(m * n * l) >= decomposition_grain())
+#endif
+        for (std::ptrdiff_t j = 0; j < n; ++j) {
+            const A* aj = &a[j * m];
+            for (std::ptrdiff_t c = 0; c < l; ++c) {
+                const A* qc = &q[c * m];
+                A        t  = 0;
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    t += aj[i] * qc[i];
+                z[c * n + j] = t;}}
+        if (it == iterations)
+            break;
+        svds_orthonormalize(&z[0], n, l);}
+
+    // z = x' q = (q' x)' = w s y', so x ~ q q' x = (q y) s w'
+    std::vector<A> values(l);
+    std::vector<A> w(n * l);
+    std::vector<A> y(l * l);
+    if (!svd_golub_kahan(&z[0], n, l, &values[0], &w[0], &y[0]))
+        throw ConvergenceException("svds");
+    std::vector<A> qy(m * std::ptrdiff_t(k));
+    for (std::ptrdiff_t c = 0; c < std::ptrdiff_t(k); ++c)
+        for (std::ptrdiff_t b = 0; b < l; ++b) {
+            const A  ybc = y[c * l + b];
+            const A* qb  = &q[b * m];
+            A*       qyc = &qy[c * m];
+            for (std::ptrdiff_t i = 0; i < m; ++i)
+                qyc[i] += qb[i] * ybc;}
+    u = decomposition_out<T>(&qy[0], m, m, k, false);
+    v = decomposition_out<T>(&w[0], n, n, k, false);
+    s = decomposition_diag<T>(&values[0], k);}
+
+#endif // Decomposition_h
@@ -0,0 +1,278 @@
+// ----------------------
+// projects/matlab/Half.h
+// Copyright (C) 2012
+// Glenn P. Downing
+// ----------------------
+
+#ifndef Half_h
+#define Half_h
+
+// --------
+// includes
+// --------
+
+#include <cstddef> // size_t
+#include <cstring> // memcpy
+
+#ifdef __F16C__
+#include <immintrin.h> // _mm256_cvtph_ps, _mm256_cvtps_ph
+#endif
+
+#include "Matrix.h"
+
+/**
+ * 16-bit floating-point element types, for storing large matrices in half the
+ * memory of float. They only store: every operation converts to float, computes
+ * in float and rounds the result back (to nearest, ties to even).
+ * Matrix products and the element-wise operators convert whole rows with the
+ * convert() kernels below (see bulk_convert); products accumulate in float.
+ *
+ * Compile with -mf16c (or -march=native) to use the hardware conversions for half.
+ */
+
+// ------------
+// float bits
+// ------------
+
+inline unsigned int float_bits (float f) {
+    unsigned int u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;}
+
+inline float bits_float (unsigned int u) {
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;}
+
+// ----
+// half
+// ----
+
+/**
+ * IEEE 754 binary16: 1 sign bit, 5 exponent bits, 10 fraction bits.
+ * Range +-65504, about 3 decimal digits.
+ */
+class half {
+    private:
+        unsigned short _bits;
+
+    public:
+        // --------
+        // encoding
+        // --------
+
+        /**
+         * @param f a float.
+         * @return the binary16 encoding of f rounded to nearest even.
+         */
+        static unsigned short encode (float f) {
+            unsigned int       u    = float_bits(f);
+            const unsigned int sign = u & 0x80000000u;
+            u ^= sign;
+            unsigned int o;
+            if (u >= 0x47800000u)                      // too large, inf or nan
+                o = u > 0x7f800000u ? 0x7e00u : 0x7c00u;
+            else if (u < 0x38800000u)                  // subnormal or zero
+                o = float_bits(bits_float(u) + 0.5f) - 0x3f000000u;
+            else {
+                const unsigned int odd = (u >> 13) & 1u;
+                u += 0xc8000fffu + odd;                // rebias the exponent and round
+                o  = u >> 13;}
+            return static_cast<unsigned short>(o | (sign >> 16));}
+
+        /**
+         * @param h a binary16 encoding.
+         * @return the float it represents (exactly).
+         */
+        static float decode (unsigned short h) {
+            unsigned int       u   = (h & 0x7fffu) << 13;
+            const unsigned int exp = u & 0x0f800000u;
+            u += 0x38000000u;                          // rebias the exponent
+            if (exp == 0x0f800000u)                    // inf or nan
+                u += 0x38000000u;
+            else if (exp == 0) {                       // subnormal or zero
+                u += 0x00800000u;
+                u  = float_bits(bits_float(u) - bits_float(0x38800000u));}
+            return bits_float(u | ((h & 0x8000u) << 16));}
+
+        // ------------
+        // constructors
+        // ------------
+
+        half () : _bits(0) {}
+
+        half (float f) : _bits(encode(f)) {}
+
+        /**
+         * @param b a binary16 encoding.
+         * @return the half with that encoding.
+         */
+        static half from_bits (unsigned short b) {
+            half h;
+            h._bits = b;
+            return h;}
+
+        // ----------
+        // conversion
+        // ----------
+
+        operator float () const {
+            return decode(_bits);}
+
+        unsigned short bits () const {
+            return _bits;}
+
+        // ---------------------
+        // compound assignments
+        // ---------------------
+
+        half& operator += (float rhs) {return *this = half(float(*this) + rhs);}
+        half& operator -= (float rhs) {return *this = half(float(*this) - rhs);}
+        half& operator *= (float rhs) {return *this = half(float(*this) * rhs);}
+        half& operator /= (float rhs) {return *this = half(float(*this) / rhs);}};
+
+// --------
+// bfloat16
+// --------
+
+/**
+ * bfloat16: the upper half of a float; 8 exponent bits, 7 fraction bits.
+ * Range of float, about 2 decimal digits.
+ */
+class bfloat16 {
+    private:
+        unsigned short _bits;
+
+    public:
+        // --------
+        // encoding
+        // --------
+
+        /**
+         * @param f a float.
+         * @return the bfloat16 encoding of f rounded to nearest even (nan stays a quiet nan).
+         */
+        static unsigned short encode (float f) {
+            const unsigned int u = float_bits(f);
+            const unsigned int r = (u + 0x7fffu + ((u >> 16) & 1u)) >> 16;
+            const unsigned int q = (u >> 16) | 0x0040u;
+            return static_cast<unsigned short>((u & 0x7fffffffu) > 0x7f800000u ? q : r);}
+
+        /**
+         * @param b a bfloat16 encoding.
+         * @return the float it represents (exactly).
+         */
+        static float decode (unsigned short b) {
+            return bits_float(static_cast<unsigned int>(b) << 16);}
+
+        // ------------
+        // constructors
+        // ------------
+
+        bfloat16 () : _bits(0) {}
+
+        bfloat16 (float f) : _bits(encode(f)) {}
+
+        /**
+         * @param b a bfloat16 encoding.
+         * @return the bfloat16 with that encoding.
+         */
+        static bfloat16 from_bits (unsigned short b) {
+            bfloat16 h;
+            h._bits = b;
+            return h;}
+
+        // ----------
+        // conversion
+        // ----------
+
+        operator float () const {
+            return decode(_bits);}
+
+        unsigned short bits () const {
+            return _bits;}
+
+        // ---------------------
+        // compound assignments
+        // ---------------------
+
+        bfloat16& operator += (float rhs) {return *this = bfloat16(float(*this) + rhs);}
+        bfloat16& operator -= (float rhs) {return *this = bfloat16(float(*this) - rhs);}
+        bfloat16& operator *= (float rhs) {return *this = bfloat16(float(*this) * rhs);}
+        bfloat16& operator /= (float rhs) {return *this = bfloat16(float(*this) / rhs);}};
+
+// --------------
+// numeric_traits
+// --------------
+
+MATRIX_NUMERIC_TRAITS(half,     18, true, float)
+MATRIX_NUMERIC_TRAITS(bfloat16, 19, true, float)
+
+// -----------
+// calloc_zero
+// -----------
+
+MATRIX_CALLOC_ZERO(half)
+MATRIX_CALLOC_ZERO(bfloat16)
+
+// ------------
+// bulk_convert
+// ------------
+
+MATRIX_BULK_CONVERT(half)
+MATRIX_BULK_CONVERT(bfloat16)
+
+/**
+ * Neither 16-bit type holds the other, so together they give float.
+ */
+template <>
+struct promote<half, bfloat16> {
+    typedef float type;};
+
+template <>
+struct promote<bfloat16, half> {
+    typedef float type;};
+
+// -------
+// convert
+// -------
+
+/**
+ * Used to widen n halfs to floats, eight at a time with F16C.
+ */
+inline void convert (const half* first, std::size_t n, float* out) {
+    std::size_t i = 0;
+#ifdef __F16C__
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first + i))));
+#endif
+    for (; i < n; ++i)
+        out[i] = half::decode(first[i].bits());}
+
+/**
+ * Used to round n floats to halfs, eight at a time with F16C.
+ */
+inline void convert (const float* first, std::size_t n, half* out) {
+    std::size_t i = 0;
+#ifdef __F16C__
+    for (; i + 8 <= n; i += 8)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_cvtps_ph(_mm256_loadu_ps(first + i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+    for (; i < n; ++i)
+        out[i] = half::from_bits(half::encode(first[i]));}
+
+/**
+ * Used to widen n bfloat16s to floats; a shift per element, which the compiler vectorizes.
+ */
+inline void convert (const bfloat16* first, std::size_t n, float* out) {
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = bfloat16::decode(first[i].bits());}
+
+/**
+ * Used to round n floats to bfloat16s; branch-free, which the compiler vectorizes.
+ */
+inline void convert (const float* first, std::size_t n, bfloat16* out) {
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = bfloat16::from_bits(bfloat16::encode(first[i]));}
+
+#endif // Half_h
@@ -12,10 +12,14 @@
 // --------
 
 #include <cassert> // assert
-#include <cstddef> // size_t
+#include <algorithm> // copy, max, min
+#include <cstddef> // ptrdiff_t, size_t
 #include <stdlib.h>
 #include <time.h>
 
+#include "Allocator.h" // NumaPolicy
+#include "Profiler.h" // MATRIX_PROFILE_SCOPE
+
 // ------
 // horzcat
 // ------
@@ -31,12 +35,15 @@
  */
 template <typename T>
 T horzcat (const T& x, const T& y) {
-    if ((x.size() != y.size()) || x.size() == 0 || x[0].size() == 0 || y[0].size() == 0)
-        throw DimensionException();
-    T result = x;
-    for (size_t r = 0; r < x.size(); r++) 
-        for (size_t c = 0; c < y[0].size(); c++) 
-            result[r].push_back(y[r][c]);
+    typedef typename T::check_type C;
+    if (C::enabled && ((x.size() != y.size()) || x.size() == 0 || x.columns() == 0 || y.columns() == 0)) {
+        C::mismatch("horzcat", x.size(), x.columns(), y.size(), y.columns());
+        return T();}
+    MATRIX_PROFILE_SCOPE("horzcat", x.size() * (x.columns() + y.columns()));
+    T result(x.size(), x.columns() + y.columns());
+    for (size_t r = 0; r < x.size(); r++) {
+        std::copy(x[r].begin(), x[r].end(), result[r].begin());
+        std::copy(y[r].begin(), y[r].end(), result[r].begin() + x.columns());}
     return result;}
 
 // ------
@@ -54,8 +61,11 @@ T horzcat (const T& x, const T& y) {
  */
 template <typename T>
 T vertcat (const T& x, const T& y) {
-    if (x.size() == 0 || y.size() == 0  || x[0].size() == 0 || y[0].size() == 0 || x[0].size() != y[0].size())
-        throw DimensionException();
+    typedef typename T::check_type C;
+    if (C::enabled && (x.size() == 0 || y.size() == 0  || x.columns() == 0 || y.columns() == 0 || x.columns() != y.columns())) {
+        C::mismatch("vertcat", x.size(), x.columns(), y.size(), y.columns());
+        return T();}
+    MATRIX_PROFILE_SCOPE("vertcat", (x.size() + y.size()) * x.columns());
     T result = x;
     for (size_t i = 0; i < y.size(); i++) result.push_back(y[i]);
     return result;}
@@ -71,16 +81,25 @@ T vertcat (const T& x, const T& y) {
  * - the specified row and column number must be positive numbers.
  * @param r the row number of the generated matrix.
  * @param c the column number of the generated matrix.
+ * The zeros come straight from calloc (see Allocator.h); only the diagonal is written,
+ * by the thread that owns each row (see NumaPolicy), so large rows stay on its node.
  * @return a new matrix of row r and column c, which contains 1's on the diagonal.
  * Reference: http://www.mathworks.com/help/matlab/ref/eye.html
  */
 template <typename T>
 T eye (std::size_t r, std::size_t c) {
-    if (r <= 0 || c <= 0) throw DimensionException();
-    size_t min = r < c ? r : c;
+    typedef typename T::check_type C;
+    if (C::enabled && (r <= 0 || c <= 0)) {
+        C::mismatch("eye", r, c);
+        return T();}
+    MATRIX_PROFILE_SCOPE("eye", r * c);
     T result(r, c, 0);
-    for (size_t i = 0; i < min; i++) 
-        result[i][i] = 1;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) if (r * c >= NumaPolicy::grain())
+#endif
+    for (size_t i = 0; i < r; i++)
+        if (i < c)
+            result[i][i] = 1;
     return result;}
 
 // ----
@@ -96,8 +115,11 @@ T eye (std::size_t r, std::size_t c) {
  */
 template <typename T>
 T diag (const T& x) {
-    if (x.size() == 0 || x[0].size() != 1)
-        throw DimensionException();
+    typedef typename T::check_type C;
+    if (C::enabled && (x.size() == 0 || x.columns() != 1)) {
+        C::mismatch("diag", x.size(), x.columns());
+        return T();}
+    MATRIX_PROFILE_SCOPE("diag", x.size() * x.size());
     T result(x.size(), x.size(), 0);
     for (size_t i = 0; i < x.size(); i++)
         result[i][i] = x[i][0];
@@ -119,8 +141,11 @@ T diag (const T& x) {
  */
 template <typename T>
 T dot (const T& x, const T& y) {
-    if (x.size() == 0 || x[0].size() != 1 || y.size() == 0 || y[0].size() != 1 || x.size() != y.size())
-        throw DimensionException();
+    typedef typename T::check_type C;
+    if (C::enabled && (x.size() == 0 || x.columns() != 1 || y.size() == 0 || y.columns() != 1 || x.size() != y.size())) {
+        C::mismatch("dot", x.size(), x.columns(), y.size(), y.columns());
+        return T();}
+    MATRIX_PROFILE_SCOPE("dot", x.size());
     T result(1,1,0);
     for (size_t i = 0; i < x.size(); i++) 
         result[0][0] += (x[i][0] * y[i][0]);
@@ -139,6 +164,26 @@ T linsolve (const T& x, const T& y) {
     // <your code>
     return x;}
 
+// ------
+// mtimes
+// ------
+
+/**
+ * Used to multiply two matrices with the given algorithm, regardless of ProductPolicy.
+ * - the matrices must not be empty.
+ * - the number of rows of y must be equal the number of columns of x.
+ * @param x the first matrix.
+ * @param y the second matrix.
+ * @param a classical_product, or strassen_product for Strassen's method (see Strassen.h).
+ * @return a new matrix, the product of x and y.
+ * Reference: http://www.mathworks.com/help/matlab/ref/mtimes.html
+ */
+template <typename T>
+T mtimes (const T& x, const T& y, product_algorithm a) {
+    T result = x;
+    result.multiply(y, a);
+    return result;}
+
 // ----
 // ones
 // ----
@@ -148,14 +193,53 @@ T linsolve (const T& x, const T& y) {
  * - the specified row and column number must be positive numbers.
  * @param r the row number of the generated matrix.
  * @param c the column number of the generated matrix.
+ * Each row is filled once, as it is allocated, by the thread that owns it (see NumaPolicy).
  * @return a new matrix of row r and column c, which is filled with only 1's.
  * Reference: http://www.mathworks.com/help/matlab/ref/ones.html
  */
 template <typename T>
 T ones (std::size_t r, std::size_t c) {
-    if (r <= 0 || c <= 0) throw DimensionException();
+    typedef typename T::check_type C;
+    if (C::enabled && (r <= 0 || c <= 0)) {
+        C::mismatch("ones", r, c);
+        return T();}
+    MATRIX_PROFILE_SCOPE("ones", r * c);
     return T(r, c, 1);}
 
+// -----------
+// rand_stream
+// -----------
+
+/**
+ * @param seed the seed of a call to rand()
+ * @param row a row of its result
+ * @return the nonzero starting state of the generator of that row
+ */
+inline unsigned int rand_stream (unsigned int seed, std::size_t row) {
+    unsigned int x = seed ^ (static_cast<unsigned int>(row) * 0x9E3779B9u);
+    x = (x ^ (x >> 16)) * 0x85EBCA6Bu;                                      // MurmurHash3's finalizer
+    x = (x ^ (x >> 13)) * 0xC2B2AE35u;
+    x =  x ^ (x >> 16);
+    return x == 0 ? 1 : x;}
+
+// ------------
+// rand_uniform
+// ------------
+
+/**
+ * Advances a xorshift generator twice.
+ * @param x its state
+ * @return a double in [0, 1) with 53 random bits
+ */
+inline double rand_uniform (unsigned int& x) {
+    unsigned int a[2];
+    for (int i = 0; i < 2; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        a[i] = x;}
+    return ((a[0] >> 5) * 67108864.0 + (a[1] >> 6)) * (1.0 / 9007199254740992.0);}
+
 // ----
 // rand
 // ----
@@ -165,18 +249,30 @@ T ones (std::size_t r, std::size_t c) {
  * - the specified row and column number must be positive numbers.
  * @param r the row number of the generated matrix.
  * @param c the column number of the generated matrix.
+ * - the elements must be of a floating-point type (an integer matrix would be all 0's,
+ * - so it does not compile).
+ * Every row has a generator of its own, seeded from the time and the C library's rand(),
+ * so the rows are filled in parallel by the threads that own them (see NumaPolicy).
  * @return a new matrix of row r and column c, which is filled with random doubles values between 0 and 1.
  * Reference: http://www.mathworks.com/help/matlab/ref/rand.html
  */
 template <typename T>
 T rand (std::size_t r, std::size_t c) {
-    if (r <= 0 || c <= 0)
-        throw DimensionException();
-    srand ( time(NULL) );
+    (void) sizeof(char[numeric_traits<typename T::element_type>::floating ? 1 : -1]); // rand needs floating-point elements
+    typedef typename T::check_type C;
+    if (C::enabled && (r <= 0 || c <= 0)) {
+        C::mismatch("rand", r, c);
+        return T();}
+    MATRIX_PROFILE_SCOPE("rand", r * c);
+    const unsigned int seed = (static_cast<unsigned int>(time(NULL)) * 2654435761u) ^ static_cast<unsigned int>(::rand());
     T result(r, c, 0);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) if (r * c >= NumaPolicy::grain())
+#endif
     for(size_t row = 0; row < r; row++){
+        unsigned int x = rand_stream(seed, row);
         for(size_t col = 0; col < c; col++){
-            result[row][col] = rand() / (double)RAND_MAX;
+            result[row][col] = rand_uniform(x);
         }
     }
     return result;
@@ -195,11 +291,14 @@ T rand (std::size_t r, std::size_t c) {
  */
 template <typename T>
 T transpose (const T& x) {
-    if (x.size() == 0 || x[0].size() == 0)
-        throw DimensionException();
-    T result(x[0].size(), x.size(), 0);
+    typedef typename T::check_type C;
+    if (C::enabled && (x.size() == 0 || x.columns() == 0)) {
+        C::mismatch("transpose", x.size(), x.columns());
+        return T();}
+    MATRIX_PROFILE_SCOPE("transpose", x.size() * x.columns());
+    T result(x.columns(), x.size(), 0);
     for(size_t r = 0; r < x.size(); r++){
-        for(size_t c = 0; c < x[0].size(); c++){
+        for(size_t c = 0; c < x.columns(); c++){
         result[c][r] = x[r][c];
         }
     }
@@ -210,21 +309,30 @@ T transpose (const T& x) {
 // ----
 
 /**
- * Used to get the lower-triangle of a square matrix.
- * - the matrix must not be empty. 
- * - the matrix must be a square matrix.
+ * Used to get the lower-triangle of a matrix: the elements on and below the kth diagonal.
+ * - the matrix must not be empty.
+ * - the matrix may be rectangular.
+ * Each row of the result starts as lazily zeroed memory (see Allocator.h) and only
+ * the kept part of the row is copied into it, so x is read once and no element is
+ * written twice.
  * @param x the matrix whose lower-triangle will be obtained.
+ * @param k the diagonal: 0 is the main diagonal, k > 0 above it, k < 0 below it.
  * @return the lower-triangle of matrix x.
  * Reference: http://www.mathworks.com/help/matlab/ref/tril.html
  */
 template <typename T>
-T tril (const T& x) {
-    T result = x;
-    if (x.size() == 0 || x[0].size() == 0 || x.size() != x[0].size())
-        throw DimensionException();
-    for (size_t r = 0; r < x.size(); r++)
-        for (size_t c = 0; c < x.size(); c++)
-            if (c > r) result[r][c] = 0;
+T tril (const T& x, std::ptrdiff_t k = 0) {
+    typedef typename T::check_type C;
+    if (C::enabled && (x.size() == 0 || x.columns() == 0)) {
+        C::mismatch("tril", x.size(), x.columns());
+        return T();}
+    MATRIX_PROFILE_SCOPE("tril", x.size() * x.columns());
+    const std::ptrdiff_t rows = x.size();
+    const std::ptrdiff_t cols = x.columns();
+    T result(rows, cols, 0);
+    for (std::ptrdiff_t r = 0; r < rows; r++) {
+        const std::ptrdiff_t n = std::min(cols, std::max(std::ptrdiff_t(0), r + k + 1));
+        std::copy(x[r].begin(), x[r].begin() + n, result[r].begin());}
     return result;}
 
 // ----
@@ -232,21 +340,28 @@ T tril (const T& x) {
 // ----
 
 /**
- * Used to get the upper-triangle of a square matrix.
- * - the matrix must not be empty. 
- * - the matrix must be a square matrix.
+ * Used to get the upper-triangle of a matrix: the elements on and above the kth diagonal.
+ * - the matrix must not be empty.
+ * - the matrix may be rectangular.
+ * Copies only the kept part of each row, as tril() does.
  * @param x the matrix whose upper-triangle will be obtained.
+ * @param k the diagonal: 0 is the main diagonal, k > 0 above it, k < 0 below it.
  * @return the upper-triangle of matrix x.
  * Reference: http://www.mathworks.com/help/matlab/ref/triu.html
  */
 template <typename T>
-T triu (const T& x) {
-    T result = x;
-    if (x.size() == 0 || x[0].size() == 0 || x.size() != x[0].size())
-        throw DimensionException();
-    for (size_t r = 0; r < x.size(); r++)
-        for (size_t c = 0; c < x.size(); c++)
-            if (c < r) result[r][c] = 0;
+T triu (const T& x, std::ptrdiff_t k = 0) {
+    typedef typename T::check_type C;
+    if (C::enabled && (x.size() == 0 || x.columns() == 0)) {
+        C::mismatch("triu", x.size(), x.columns());
+        return T();}
+    MATRIX_PROFILE_SCOPE("triu", x.size() * x.columns());
+    const std::ptrdiff_t rows = x.size();
+    const std::ptrdiff_t cols = x.columns();
+    T result(rows, cols, 0);
+    for (std::ptrdiff_t r = 0; r < rows; r++) {
+        const std::ptrdiff_t b = std::min(cols, std::max(std::ptrdiff_t(0), r + k));
+        std::copy(x[r].begin() + b, x[r].end(), result[r].begin() + b);}
     return result;}
 
 // -----
@@ -258,12 +373,18 @@ T triu (const T& x) {
  * - the specified row and column number must be positive numbers.
  * @param r the row number of the generated matrix.
  * @param c the column number of the generated matrix.
+ * The rows come straight from calloc (see Allocator.h): with C++11, large ones are
+ * fresh pages the OS zeroes on first touch, so no pass is made over the memory.
  * @return a new matrix of row r and column c, which is filled with only 0's.
  * Reference: http://www.mathworks.com/help/matlab/ref/zeros.html
  */
 template <typename T>
 T zeros (std::size_t r, std::size_t c) {
-    if (r <= 0 || c <= 0) throw DimensionException();
+    typedef typename T::check_type C;
+    if (C::enabled && (r <= 0 || c <= 0)) {
+        C::mismatch("zeros", r, c);
+        return T();}
+    MATRIX_PROFILE_SCOPE("zeros", r * c);
     return T(r, c, 0);}
 
 #endif // MatLab_h
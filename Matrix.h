@@ -11,12 +11,19 @@
 // includes
 // --------
 
+#include <algorithm> // fill, min
 #include <cassert> // assert
 #include <cstddef> // ptrdiff_t, size_t
+#include <cstring> // memcmp
+#include <new>     // bad_alloc
 #include <vector>  // vector
 #include <iostream>
 #include <string>
 
+#include "Allocator.h" // matrix_allocator, calloc_zero, NumaPolicy, zero_iterator
+#include "Profiler.h" // MATRIX_PROFILE_SCOPE, MATRIX_PROFILE_ALLOC, MATRIX_PROFILE_COPY
+#include "Strassen.h" // ProductPolicy, strassen_run
+
 // ------------------
 // DimensionException
 // ------------------
@@ -24,16 +31,370 @@
 /**
  * The exception thrown when a mismatch in the dimension of
  * the matrices being operated on occurs.
+ * Only the shapes are stored; the message is built when err() is called,
+ * so throwing does not allocate.
  */
 class DimensionException {
 private:
     std::string msg;
+    const char* op;
+    std::size_t lr, lc, rr, rc;
+    int         operands;
+
+    static void append (std::string& s, std::size_t n) {
+        char buffer[24];
+        char* p = buffer + sizeof(buffer);
+        do {*--p = static_cast<char>('0' + n % 10); n /= 10;} while (n != 0);
+        s.append(p, buffer + sizeof(buffer));}
+
+    static void append (std::string& s, std::size_t r, std::size_t c) {
+        append(s, r);
+        s += 'x';
+        append(s, c);}
+
 public:
-    DimensionException(std::string s) {msg = s;}
-    DimensionException() {msg = "Dimension not matched.\n";}
-    std::string err() {return msg;}
+    DimensionException(std::string s) : msg(s), op(0), lr(0), lc(0), rr(0), rc(0), operands(0) {}
+    DimensionException() : op(0), lr(0), lc(0), rr(0), rc(0), operands(0) {}
+    DimensionException(const char* o, std::size_t r, std::size_t c) :
+            op(o), lr(r), lc(c), rr(0), rc(0), operands(1) {}
+    DimensionException(const char* o, std::size_t r1, std::size_t c1, std::size_t r2, std::size_t c2) :
+            op(o), lr(r1), lc(c1), rr(r2), rc(c2), operands(2) {}
+
+    /**
+     * @return the message, e.g. "Dimension not matched: operator += (2x3, 3x2).\n"
+     */
+    std::string err() const {
+        if (!msg.empty() || op == 0)
+            return msg.empty() ? std::string("Dimension not matched.\n") : msg;
+        std::string s = "Dimension not matched: ";
+        s += op;
+        s += " (";
+        append(s, lr, lc);
+        if (operands == 2) {
+            s += ", ";
+            append(s, rr, rc);}
+        s += ").\n";
+        return s;}
 };
 
+// ----------
+// ThrowCheck
+// ----------
+
+/**
+ * Dimension check policy: throw a DimensionException on a mismatch (the default).
+ *
+ * A check policy has a compile-time constant "enabled" and a static mismatch()
+ * that is called with the operation and the shapes of its operands when a check
+ * fails. The operation returns right after mismatch() returns (leaving its target
+ * unchanged, or returning an empty matrix). When "enabled" is false the checks are
+ * removed at compile time. When the compile-time constant "audit" is true, the
+ * operators of Matrix also check that no row was resized behind the cached shape,
+ * a pass over the rows per operation, and report it as a mismatch of the shape.
+ *
+ * The default policy of Matrix is MATRIX_CHECK, which may be set on the command
+ * line, e.g. -DMATRIX_CHECK=DebugCheck.
+ */
+struct ThrowCheck {
+    static const bool enabled = true;
+    static const bool audit   = false;
+
+    static void mismatch (const char* op, std::size_t r, std::size_t c) {
+        throw DimensionException(op, r, c);}
+
+    static void mismatch (const char* op, std::size_t lr, std::size_t lc, std::size_t rr, std::size_t rc) {
+        throw DimensionException(op, lr, lc, rr, rc);}};
+
+// ----------
+// DebugCheck
+// ----------
+
+/**
+ * Dimension check policy: assert in debug builds, no checks at all with NDEBUG.
+ * Debug builds also audit the rows against the cached shape.
+ */
+struct DebugCheck {
+#ifdef NDEBUG
+    static const bool enabled = false;
+    static const bool audit   = false;
+#else
+    static const bool enabled = true;
+    static const bool audit   = true;
+#endif
+
+    static void mismatch (const char*, std::size_t, std::size_t) {
+        assert(!"Dimension not matched.");}
+
+    static void mismatch (const char*, std::size_t, std::size_t, std::size_t, std::size_t) {
+        assert(!"Dimension not matched.");}};
+
+// -------
+// NoCheck
+// -------
+
+/**
+ * Dimension check policy: no checks; a mismatch is undefined behavior.
+ */
+struct NoCheck {
+    static const bool enabled = false;
+    static const bool audit   = false;
+
+    static void mismatch (const char*, std::size_t, std::size_t) {}
+
+    static void mismatch (const char*, std::size_t, std::size_t, std::size_t, std::size_t) {}};
+
+// --------------
+// ErrorCodeCheck
+// --------------
+
+#if __cplusplus >= 201103L
+#define MATRIX_THREAD_LOCAL thread_local
+#else
+#define MATRIX_THREAD_LOCAL
+#endif
+
+/**
+ * Dimension check policy: record the mismatch and skip the operation.
+ * The error is per thread (with C++11) and sticks until clear() is called.
+ */
+struct ErrorCodeCheck {
+    static const bool enabled = true;
+    static const bool audit   = false;
+
+    static void mismatch (const char* op, std::size_t r, std::size_t c) {
+        if (!failed())
+            error() = DimensionException(op, r, c);
+        failed() = true;}
+
+    static void mismatch (const char* op, std::size_t lr, std::size_t lc, std::size_t rr, std::size_t rc) {
+        if (!failed())
+            error() = DimensionException(op, lr, lc, rr, rc);
+        failed() = true;}
+
+    /**
+     * @return whether a mismatch occurred since the last clear().
+     */
+    static bool& failed () {
+        static MATRIX_THREAD_LOCAL bool f = false;
+        return f;}
+
+    /**
+     * @return the first mismatch since the last clear().
+     */
+    static DimensionException& error () {
+        static MATRIX_THREAD_LOCAL DimensionException e;
+        return e;}
+
+    static void clear () {
+        failed() = false;
+        error()  = DimensionException();}};
+
+#ifndef MATRIX_CHECK
+#define MATRIX_CHECK ThrowCheck
+#endif
+
+// --------------
+// numeric_traits
+// --------------
+
+/**
+ * The arithmetic properties of an element type:
+ * - rank: the position in the promotion order; the type of the higher rank wins.
+ * - floating: whether the type is a floating-point type.
+ * - accumulate_type: the type sums of products are accumulated in, wider than T
+ *   where there is a wider type: bool and the small integers in int, int in long,
+ *   float in double.
+ * - numeric: whether the type has the above, i.e. a specialization.
+ * Element types without a specialization accumulate in their own type and cannot be
+ * mixed with other types.
+ */
+template <typename T>
+struct numeric_traits {
+    static const bool numeric = false;
+    typedef T accumulate_type;};
+
+#define MATRIX_NUMERIC_TRAITS(T, r, f, A)                 \
+    template <>                                            \
+    struct numeric_traits<T> {                             \
+        static const bool numeric  = true;                 \
+        static const int  rank     = r;                    \
+        static const bool floating = f;                    \
+        typedef A accumulate_type;};
+
+MATRIX_NUMERIC_TRAITS(bool,               1,  false, int)
+MATRIX_NUMERIC_TRAITS(char,               2,  false, int)
+MATRIX_NUMERIC_TRAITS(signed char,        2,  false, int)
+MATRIX_NUMERIC_TRAITS(unsigned char,      3,  false, unsigned int)
+MATRIX_NUMERIC_TRAITS(short,              4,  false, int)
+MATRIX_NUMERIC_TRAITS(unsigned short,     5,  false, unsigned int)
+MATRIX_NUMERIC_TRAITS(int,                6,  false, long)
+MATRIX_NUMERIC_TRAITS(unsigned int,       7,  false, unsigned long)
+MATRIX_NUMERIC_TRAITS(long,               8,  false, long)
+MATRIX_NUMERIC_TRAITS(unsigned long,      9,  false, unsigned long)
+#if __cplusplus >= 201103L
+MATRIX_NUMERIC_TRAITS(long long,          10, false, long long)
+MATRIX_NUMERIC_TRAITS(unsigned long long, 11, false, unsigned long long)
+#endif
+MATRIX_NUMERIC_TRAITS(float,              20, true,  double)
+MATRIX_NUMERIC_TRAITS(double,             21, true,  double)
+MATRIX_NUMERIC_TRAITS(long double,        22, true,  long double)
+
+// -------
+// promote
+// -------
+
+template <bool B, typename T, typename U>
+struct choose {
+    typedef T type;};
+
+template <typename T, typename U>
+struct choose<false, T, U> {
+    typedef U type;};
+
+/**
+ * The element type of the result of combining a T with a U:
+ * the one of the higher rank, e.g. int and double give double.
+ */
+template <typename T, typename U>
+struct promote {
+    typedef typename choose<(numeric_traits<T>::rank >= numeric_traits<U>::rank), T, U>::type type;};
+
+// -------
+// convert
+// -------
+
+/**
+ * Used to convert n elements from one element type to another.
+ * Element types with a cheaper bulk conversion (see Half.h) overload this.
+ * @param first the elements to convert.
+ * @param n the number of elements.
+ * @param out where the converted elements are written.
+ */
+template <typename From, typename To>
+inline void convert (const From* first, std::size_t n, To* out) {
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = static_cast<To>(first[i]);}
+
+// -----------
+// convert_row
+// -----------
+
+/**
+ * Used to convert the first n elements of a row, see convert().
+ * Rows of bool are packed bits, which are converted one at a time.
+ * @param row the row to convert.
+ * @param n the number of elements.
+ * @param out where the converted elements are written.
+ */
+template <typename Row, typename To>
+inline void convert_row (const Row& row, std::size_t n, To* out) {
+    convert(&row[0], n, out);}
+
+template <typename A, typename To>
+inline void convert_row (const std::vector<bool, A>& row, std::size_t n, To* out) {
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = static_cast<To>(row[i]);}
+
+/**
+ * Used to convert n elements into the front of a row, see convert().
+ * @param first the elements to convert.
+ * @param n the number of elements.
+ * @param row where the converted elements are written.
+ */
+template <typename From, typename Row>
+inline void convert_row (const From* first, std::size_t n, Row& row) {
+    convert(first, n, &row[0]);}
+
+template <typename From, typename A>
+inline void convert_row (const From* first, std::size_t n, std::vector<bool, A>& row) {
+    for (std::size_t i = 0; i < n; ++i)
+        row[i] = (first[i] != From());}
+
+/**
+ * Used to convert the first n elements of one row into the front of another.
+ * @param from the row to convert.
+ * @param n the number of elements.
+ * @param to where the converted elements are written.
+ */
+template <typename From, typename To>
+inline void convert_row_into (const From& from, std::size_t n, To& to) {
+    convert_row(from, n, &to[0]);}
+
+template <typename From, typename A>
+inline void convert_row_into (const From& from, std::size_t n, std::vector<bool, A>& to) {
+    for (std::size_t i = 0; i < n; ++i)
+        to[i] = (from[i] != typename From::value_type());}
+
+// ------------
+// bulk_convert
+// ------------
+
+/**
+ * Whether T has convert() kernels to and from numeric_traits<T>::accumulate_type
+ * that beat converting one element at a time (see Half.h). The element-wise
+ * operators of Matrix then work on whole rows converted to that type and back.
+ */
+template <typename T>
+struct bulk_convert {
+    static const bool value = false;};
+
+#define MATRIX_BULK_CONVERT(T)           \
+    template <>                          \
+    struct bulk_convert<T> {             \
+        static const bool value = true;};
+
+// -------------------
+// element operations
+// -------------------
+
+/**
+ * The element-wise operations of Matrix, on two elements of a type A.
+ */
+struct plus_op {
+    template <typename A>
+    static A apply (const A& x, const A& y) {
+        return x + y;}};
+
+struct minus_op {
+    template <typename A>
+    static A apply (const A& x, const A& y) {
+        return x - y;}};
+
+struct times_op {
+    template <typename A>
+    static A apply (const A& x, const A& y) {
+        return x * y;}};
+
+struct equal_op {
+    template <typename A>
+    static bool apply (const A& x, const A& y) {
+        return x == y;}};
+
+struct not_equal_op {
+    template <typename A>
+    static bool apply (const A& x, const A& y) {
+        return x != y;}};
+
+struct less_op {
+    template <typename A>
+    static bool apply (const A& x, const A& y) {
+        return x < y;}};
+
+struct less_equal_op {
+    template <typename A>
+    static bool apply (const A& x, const A& y) {
+        return x <= y;}};
+
+struct greater_op {
+    template <typename A>
+    static bool apply (const A& x, const A& y) {
+        return x > y;}};
+
+struct greater_equal_op {
+    template <typename A>
+    static bool apply (const A& x, const A& y) {
+        return x >= y;}};
+
 // ------
 // Matrix
 // ------
@@ -42,16 +403,28 @@ public:
  * Design decision:
  *
  * When the first index of a matrix (the row) or the second index of a matrix (the column)
- * happen to be zero, we consider it to be unoperatable. Therefore, we throw an DimensionException.
+ * happen to be zero, we consider it to be unoperatable. Therefore, we throw an DimensionException
+ * (or do whatever the check policy C says, see ThrowCheck).
+ *
+ * The shape is kept alongside the rows, so the rows handed out by operator [] and
+ * the iterators must not be resized (m[r].push_back(v) and the like); use
+ * push_back() to add rows. DebugCheck (see ThrowCheck) asserts that they were not.
+ *
+ * The rows are std::vector<T, matrix_allocator<T> > (row_type), not std::vector<T>:
+ * code that binds a std::vector<T>& to a row, or assigns a std::vector<T> to one,
+ * must use Matrix::row_type& (or a reference to auto) and row.assign(v.begin(), v.end())
+ * instead. push_back() takes a row with any allocator.
  */
-template <typename T>
+template <typename T, typename C = MATRIX_CHECK>
 class Matrix {
     public:
         // --------
         // typedefs
         // --------
 
-        typedef typename std::vector< std::vector<T> >    container_type;
+        typedef matrix_allocator<T>                       allocator_type;
+        typedef typename std::vector<T, allocator_type>   row_type;
+        typedef typename std::vector<row_type>            container_type;
         typedef typename container_type::value_type       value_type;
 
         typedef typename container_type::size_type        size_type;
@@ -66,6 +439,9 @@ class Matrix {
         typedef typename container_type::iterator         iterator;
         typedef typename container_type::const_iterator   const_iterator;
 
+        typedef T                                         element_type;
+        typedef C                                         check_type;
+
     public:
         // -----------
         // operator ==
@@ -81,17 +457,11 @@ class Matrix {
          * @return a matrix of boolean values which contains either 1 or 0 depending on the result of
          * comparison.
          */
-        friend Matrix<bool> operator == (const Matrix& lhs, const Matrix& rhs) {
-            if ((lhs._m.size() != rhs._m.size()) || lhs._m.size() == 0 || lhs._m[0].size() != rhs._m[0].size() || lhs._m[0].size() == 0)
-                throw DimensionException();
-            Matrix<bool> result = Matrix<bool> (lhs._m.size(), lhs._m[0].size());
-            for (size_type r = 0; r < lhs._m.size(); r++) {
-                for (size_type c = 0; c < lhs._m[0].size(); c++) {
-                    if (lhs._m[r][c] == rhs._m[r][c]) result[r][c] = true;
-                    else result[r][c] = false;
-                }
-            }
-            return result;}
+        friend Matrix<bool, C> operator == (const Matrix& lhs, const Matrix& rhs) {
+            if (!lhs.conforms("operator ==", rhs))
+                return Matrix<bool, C>();
+            MATRIX_PROFILE_SCOPE("operator ==", lhs.elements());
+            return lhs.compare<equal_op>(rhs);}
 
         // -----------
         // operator !=
@@ -107,17 +477,11 @@ class Matrix {
          * @return a matrix of boolean values which contains either 1 or 0 depending on the result
          * of comparison.
          */
-        friend Matrix<bool> operator != (const Matrix& lhs, const Matrix& rhs) {
-            if ((lhs._m.size() != rhs._m.size()) || lhs._m.size() == 0 || lhs._m[0].size() != rhs._m[0].size() || lhs._m[0].size() == 0)
-                throw DimensionException();
-            Matrix<bool> result = Matrix<bool> (lhs._m.size(), lhs._m[0].size());
-            for (size_type r = 0; r < lhs._m.size(); r++) {
-                for (size_type c = 0; c < lhs._m[0].size(); c++) {
-                    if (lhs._m[r][c] != rhs._m[r][c]) result[r][c] = true;
-                    else result[r][c] = false;
-                }
-            }
-            return result;}
+        friend Matrix<bool, C> operator != (const Matrix& lhs, const Matrix& rhs) {
+            if (!lhs.conforms("operator !=", rhs))
+                return Matrix<bool, C>();
+            MATRIX_PROFILE_SCOPE("operator !=", lhs.elements());
+            return lhs.compare<not_equal_op>(rhs);}
 
         // ----------
         // operator <
@@ -134,17 +498,11 @@ class Matrix {
          * @return a matrix of boolean values which contains either 1 or 0 depending on the result of
          * comparison.
          */
-        friend Matrix<bool> operator < (const Matrix& lhs, const Matrix& rhs) {
-            if ((lhs._m.size() != rhs._m.size()) || lhs._m.size() == 0 || lhs._m[0].size() != rhs._m[0].size() || lhs._m[0].size() == 0)
-                throw DimensionException();
-            Matrix<bool> result = Matrix<bool> (lhs._m.size(), lhs._m[0].size());
-            for (size_type r = 0; r < lhs._m.size(); r++) {
-                for (size_type c = 0; c < lhs._m[0].size(); c++) {
-                    if (lhs._m[r][c] < rhs._m[r][c]) result[r][c] = true;
-                    else result[r][c] = false;
-                }
-            }
-            return result;}
+        friend Matrix<bool, C> operator < (const Matrix& lhs, const Matrix& rhs) {
+            if (!lhs.conforms("operator <", rhs))
+                return Matrix<bool, C>();
+            MATRIX_PROFILE_SCOPE("operator <", lhs.elements());
+            return lhs.compare<less_op>(rhs);}
 
         // -----------
         // operator <=
@@ -161,17 +519,11 @@ class Matrix {
          * @return a matrix of boolean values which contains either 1 or 0 depending on the result
          * of comparison.
          */
-        friend Matrix<bool> operator <= (const Matrix& lhs, const Matrix& rhs) {
-            if ((lhs._m.size() != rhs._m.size()) || lhs._m.size() == 0 || lhs._m[0].size() != rhs._m[0].size() || lhs._m[0].size() == 0)
-                throw DimensionException();
-            Matrix<bool> result = Matrix<bool> (lhs._m.size(), lhs._m[0].size());
-            for (size_type r = 0; r < lhs._m.size(); r++) {
-                for (size_type c = 0; c < lhs._m[0].size(); c++) {
-                    if (lhs._m[r][c] <= rhs._m[r][c]) result[r][c] = true;
-                    else result[r][c] = false;
-                }
-            }
-            return result;}
+        friend Matrix<bool, C> operator <= (const Matrix& lhs, const Matrix& rhs) {
+            if (!lhs.conforms("operator <=", rhs))
+                return Matrix<bool, C>();
+            MATRIX_PROFILE_SCOPE("operator <=", lhs.elements());
+            return lhs.compare<less_equal_op>(rhs);}
             
 
         // ----------
@@ -189,17 +541,11 @@ class Matrix {
          * @return a matrix of boolean values which contains either 1 or 0 depending on the result
          * of comparison.
          */
-        friend Matrix<bool> operator > (const Matrix& lhs, const Matrix& rhs) {
-            if ((lhs._m.size() != rhs._m.size()) || lhs._m.size() == 0 || lhs._m[0].size() != rhs._m[0].size() || lhs._m[0].size() == 0)
-                throw DimensionException();
-            Matrix<bool> result = Matrix<bool> (lhs._m.size(), lhs._m[0].size());
-            for (size_type r = 0; r < lhs._m.size(); r++) {
-                for (size_type c = 0; c < lhs._m[0].size(); c++) {
-                    if (lhs._m[r][c] > rhs._m[r][c]) result[r][c] = true;
-                    else result[r][c] = false;
-                }
-            }
-            return result;}
+        friend Matrix<bool, C> operator > (const Matrix& lhs, const Matrix& rhs) {
+            if (!lhs.conforms("operator >", rhs))
+                return Matrix<bool, C>();
+            MATRIX_PROFILE_SCOPE("operator >", lhs.elements());
+            return lhs.compare<greater_op>(rhs);}
 
         // -----------
         // operator >=
@@ -216,17 +562,11 @@ class Matrix {
          * @return a matrix of boolean values which contains either 1 or 0 depending on the result 
          * of comparison.
          */
-        friend Matrix<bool> operator >= (const Matrix& lhs, const Matrix& rhs) {
-            if ((lhs._m.size() != rhs._m.size()) || lhs._m.size() == 0 || lhs._m[0].size() != rhs._m[0].size() || lhs._m[0].size() == 0)
-                throw DimensionException();
-            Matrix<bool> result = Matrix<bool> (lhs._m.size(), lhs._m[0].size());
-            for (size_type r = 0; r < lhs._m.size(); r++) {
-                for (size_type c = 0; c < lhs._m[0].size(); c++) {
-                    if (lhs._m[r][c] >= rhs._m[r][c]) result[r][c] = true;
-                    else result[r][c] = false;
-                }
-            }
-            return result;}
+        friend Matrix<bool, C> operator >= (const Matrix& lhs, const Matrix& rhs) {
+            if (!lhs.conforms("operator >=", rhs))
+                return Matrix<bool, C>();
+            MATRIX_PROFILE_SCOPE("operator >=", lhs.elements());
+            return lhs.compare<greater_equal_op>(rhs);}
 
         // ----------
         // operator +
@@ -308,26 +648,302 @@ class Matrix {
         // data
         // ----
 
-        std::vector< std::vector<T> > _m;
+        container_type _m;
+        size_type      _rows;
+        size_type      _cols;
 
         // -----
         // valid
         // -----
 
         /**
-         * Used to test the validity of this matrix: every row has the same number of columns.
+         * Used to test the validity of this matrix: every row has the cached number of columns.
          * @return a boolean that indicates wether it is a valid matrix or not.
          */
         bool valid () const {
-            if (_m.size() == 0) return true;
-            else {
-                size_type s = _m[0].size();
-                for (size_type i = 0; i < _m.size(); i++) {
-                    if (_m[i].size() != s) return false;
-                }
+            if (_m.size() != _rows) return false;
+            for (size_type i = 0; i < _m.size(); i++) {
+                if (_m[i].size() != _cols) return false;
             }
             return true;}
 
+        // --------
+        // conforms
+        // --------
+
+        /**
+         * Used to check that rhs has the same, non-empty, shape as this matrix.
+         * Compiles to nothing when the check policy is disabled.
+         * @param op the operation, for the diagnostic.
+         * @param rhs the matrix on the right hand side.
+         * @return false if the check failed and the operation must not proceed.
+         */
+        bool conforms (const char* op, const Matrix& rhs) const {
+            if (!intact(op) || !rhs.intact(op))
+                return false;
+            if (!C::enabled || (_rows == rhs._rows && _cols == rhs._cols && _rows != 0 && _cols != 0))
+                return true;
+            C::mismatch(op, _rows, _cols, rhs._rows, rhs._cols);
+            return false;}
+
+        // ------
+        // intact
+        // ------
+
+        /**
+         * Used to audit that no row was resized behind the cached shape, if the check
+         * policy says so; compiles to nothing otherwise.
+         * @param op the operation, for the diagnostic.
+         * @return false if the audit failed and the operation must not proceed.
+         */
+        bool intact (const char* op) const {
+            if (!C::audit || valid())
+                return true;
+            C::mismatch(op, _rows, _cols);
+            return false;}
+
+        // -------
+        // is_zero
+        // -------
+
+        /**
+         * @return whether v is all zero bits, i.e. what calloc gives.
+         */
+        static bool is_zero (const T& v) {
+            if (!calloc_zero<T>::value) return false;
+            const T zero = T();
+            return std::memcmp(&v, &zero, sizeof(T)) == 0;}
+
+        // ----------
+        // zeroed_row
+        // ----------
+
+        /**
+         * @param c the number of columns.
+         * @param a an allocator, whose placement is kept.
+         * @return a row of c T()'s; with C++11 and calloc_zero types, straight from zeroed
+         * memory, without a pass over it (see zero_iterator).
+         */
+        static value_type zeroed_row (size_type c, const allocator_type& a) {
+            const allocator_type z(true, a.placement(), a.node());
+#if __cplusplus >= 201103L
+            return value_type(zero_iterator(0), zero_iterator(c), z);
+#else
+            return value_type(c, T(), z);
+#endif
+            }
+
+        // -------------
+        // row_allocator
+        // -------------
+
+        /**
+         * @return the allocator of the rows of an r x c matrix: placed by NumaPolicy if
+         * the matrix has at least MATRIX_NUMA_THRESHOLD bytes, plain otherwise.
+         */
+        static allocator_type row_allocator (size_type r, size_type c, bool zeroed) {
+            if (NumaPolicy::placement() == numa_first_touch || r * c * sizeof(T) < MATRIX_NUMA_THRESHOLD)
+                return allocator_type(zeroed);
+            return allocator_type(zeroed, NumaPolicy::placement(), NumaPolicy::node());}
+
+        // ----------
+        // place_rows
+        // ----------
+
+        /**
+         * Fills the rows of m with c v's each. Every row is made by the thread whose
+         * static block of rows it falls in, the same blocks that the row loops below
+         * work on, so that its pages are first touched on that thread's node (see
+         * NumaPolicy). Zero rows are left untouched until that thread writes them.
+         * The rows get the allocator of row_allocator().
+         * @param m the rows, all empty.
+         * @param c the number of columns.
+         * @param v the value of the elements.
+         * @throws bad_alloc
+         */
+        static void place_rows (container_type& m, size_type c, const T& v) {
+            const size_type      r    = m.size();
+            const bool           zero = is_zero(v);
+            const allocator_type a    = row_allocator(r, c, zero);
+            bool failed = false;
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(static) if (r * c >= NumaPolicy::grain())
+#endif
+            for (size_type i = 0; i < r; i++) {
+                try {
+                    if (zero) zeroed_row(c, a).swap(m[i]);
+                    else value_type(c, v, a).swap(m[i]);}
+                catch (const std::bad_alloc&) {
+#ifdef _OPENMP
+                    #pragma omp critical (matrix_bad_alloc)
+#endif
+                    failed = true;}}
+            if (failed)
+                throw std::bad_alloc();}
+
+        /**
+         * Assigns the rows of that to those of m, placed as above. Rows of m with
+         * room enough are reused; the others are made anew by row_allocator().
+         * @param m the rows, as many as that has.
+         * @param that the rows to copy.
+         * @param c the number of columns.
+         * @throws bad_alloc
+         */
+        static void place_rows (container_type& m, const container_type& that, size_type c) {
+            const size_type      r = m.size();
+            const allocator_type a = row_allocator(r, c, false);
+            bool failed = false;
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(static) if (r * c >= NumaPolicy::grain())
+#endif
+            for (size_type i = 0; i < r; i++) {
+                try {
+                    if (m[i].capacity() >= that[i].size())
+                        m[i] = that[i];
+                    else
+                        value_type(that[i].begin(), that[i].end(), a).swap(m[i]);}
+                catch (const std::bad_alloc&) {
+#ifdef _OPENMP
+                    #pragma omp critical (matrix_bad_alloc)
+#endif
+                    failed = true;}}
+            if (failed)
+                throw std::bad_alloc();}
+
+        // --------
+        // elements
+        // --------
+
+        /**
+         * @return the number of elements of this matrix.
+         */
+        size_type elements () const {
+            return _rows * _cols;}
+
+        // -------
+        // compare
+        // -------
+
+        /**
+         * Used to compare every element of this matrix with the one of rhs at the same
+         * place. Types with bulk_convert compare whole rows converted to their
+         * numeric_traits<T>::accumulate_type.
+         * @param rhs the matrix on the right hand side, of the same shape.
+         * @return the matrix of the results of F::apply().
+         */
+        template <typename F>
+        Matrix<bool, C> compare (const Matrix& rhs) const {
+            Matrix<bool, C> result(_rows, _cols);
+            if (bulk_convert<T>::value && _cols != 0) {
+                typedef typename numeric_traits<T>::accumulate_type A;
+                std::vector<A> x(_cols);
+                std::vector<A> y(_cols);
+                for (size_type r = 0; r < _rows; r++) {
+                    convert_row(_m[r], _cols, &x[0]);
+                    convert_row(rhs._m[r], _cols, &y[0]);
+                    for (size_type c = 0; c < _cols; c++)
+                        result[r][c] = F::template apply<A>(x[c], y[c]);}
+                return result;}
+            for (size_type r = 0; r < _rows; r++)
+                for (size_type c = 0; c < _cols; c++)
+                    result[r][c] = F::template apply<T>(_m[r][c], rhs._m[r][c]);
+            return result;}
+
+        // ---------
+        // transform
+        // ---------
+
+        /**
+         * Used to replace every element x of this matrix by F::apply(x, y), with y the
+         * element of rhs at the same place, in parallel over the row blocks of
+         * place_rows(). Types with bulk_convert work on whole rows converted to their
+         * numeric_traits<T>::accumulate_type and back.
+         * @param rhs the matrix on the right hand side, of the same shape.
+         * @throws bad_alloc
+         */
+        template <typename F>
+        void transform (const Matrix& rhs) {
+            if (bulk_convert<T>::value && _cols != 0) {
+                typedef typename numeric_traits<T>::accumulate_type A;
+                bool failed = false;
+#ifdef _OPENMP
+                #pragma omp parallel if (elements() >= NumaPolicy::grain())
+#endif
+                {
+                std::vector<A> x;   // per thread
+                std::vector<A> y;
+#ifdef _OPENMP
+                #pragma omp for schedule(static)
+#endif
+                for (size_type r = 0; r < _rows; r++) {
+                    try {
+                        x.resize(_cols);
+                        y.resize(_cols);
+                        convert_row(_m[r], _cols, &x[0]);
+                        convert_row(rhs._m[r], _cols, &y[0]);
+                        for (size_type c = 0; c < _cols; c++)
+                            x[c] = F::template apply<A>(x[c], y[c]);
+                        convert_row(&x[0], _cols, _m[r]);}
+                    catch (const std::bad_alloc&) {
+#ifdef _OPENMP
+                        #pragma omp critical (matrix_bad_alloc)
+#endif
+                        failed = true;}
+                }
+                }
+                if (failed)
+                    throw std::bad_alloc();
+                return;}
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(static) if (elements() >= NumaPolicy::grain())
+#endif
+            for (size_type r = 0; r < _rows; r++)
+                for (size_type c = 0; c < _cols; c++)
+                    _m[r][c] = F::template apply<T>(_m[r][c], rhs._m[r][c]);}
+
+        /**
+         * Used to replace every element x of this matrix by F::apply(x, rhs), as above.
+         * @param rhs the scalar on the right hand side.
+         * @throws bad_alloc
+         */
+        template <typename F>
+        void transform (const T& rhs) {
+            if (bulk_convert<T>::value && _cols != 0) {
+                typedef typename numeric_traits<T>::accumulate_type A;
+                const A y = static_cast<A>(rhs);
+                bool failed = false;
+#ifdef _OPENMP
+                #pragma omp parallel if (elements() >= NumaPolicy::grain())
+#endif
+                {
+                std::vector<A> x;   // per thread
+#ifdef _OPENMP
+                #pragma omp for schedule(static)
+#endif
+                for (size_type r = 0; r < _rows; r++) {
+                    try {
+                        x.resize(_cols);
+                        convert_row(_m[r], _cols, &x[0]);
+                        for (size_type c = 0; c < _cols; c++)
+                            x[c] = F::template apply<A>(x[c], y);
+                        convert_row(&x[0], _cols, _m[r]);}
+                    catch (const std::bad_alloc&) {
+#ifdef _OPENMP
+                        #pragma omp critical (matrix_bad_alloc)
+#endif
+                        failed = true;}
+                }
+                }
+                if (failed)
+                    throw std::bad_alloc();
+                return;}
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(static) if (elements() >= NumaPolicy::grain())
+#endif
+            for (size_type r = 0; r < _rows; r++)
+                for (size_type c = 0; c < _cols; c++)
+                    _m[r][c] = F::template apply<T>(_m[r][c], rhs);}
+
     public:
         // ------------
         // constructors
@@ -339,14 +955,69 @@ class Matrix {
          * @param c indicates number of columns matrix will have.
          * @param v indicates the value of elements type T that will be initialized in matrix.
          */
-        Matrix (size_type r = 0, size_type c = 0, const T& v = T()) {
-            _m = std::vector< std::vector<T> >(r, std::vector<T>(c, v));
-            assert(valid());}
+        Matrix (size_type r = 0, size_type c = 0, const T& v = T()) :
+                _m(r),
+                _rows(r),
+                _cols(r == 0 ? 0 : c) {
+            MATRIX_PROFILE_ALLOC(r * c * sizeof(T));
+            place_rows(_m, _cols, v);}
+
+        // Copies are made row block by row block, like construction (see place_rows),
+        // and counted, so that temporaries show up in the profile
+        Matrix (const Matrix& that) : _m(that._rows), _rows(that._rows), _cols(that._cols) {
+            MATRIX_PROFILE_COPY(elements() * sizeof(T));
+            place_rows(_m, that._m, _cols);}
+
+#if __cplusplus >= 201103L
+        Matrix (Matrix&& that) : _m(std::move(that._m)), _rows(that._rows), _cols(that._cols) {
+            that._rows = that._cols = 0;}
+#endif
 
-        // Default copy, destructor, and copy assignment
-        // Matrix  (const Matrix<T>&);
-        // ~Matrix ();
-        // Matrix& operator = (const Matrix&);
+        /**
+         * Reuses the rows of this matrix where they have room enough (see place_rows).
+         * @throws bad_alloc leaving this matrix empty, so that its shape stays true
+         */
+        Matrix& operator = (const Matrix& that) {
+            if (this == &that)
+                return *this;
+            MATRIX_PROFILE_COPY(that.elements() * sizeof(T));
+            try {
+                _m.resize(that._rows, value_type());
+                place_rows(_m, that._m, that._cols);}
+            catch (...) {
+                container_type().swap(_m);
+                _rows = _cols = 0;
+                throw;}
+            _rows = that._rows;
+            _cols = that._cols;
+            return *this;}
+
+#if __cplusplus >= 201103L
+        Matrix& operator = (Matrix&& that) {
+            _m    = std::move(that._m);
+            _rows = that._rows;
+            _cols = that._cols;
+            that._rows = that._cols = 0;
+            return *this;}
+#endif
+
+        /**
+         * Constructs a matrix from a matrix of another element type, converting every element.
+         * @param that the matrix to convert.
+         */
+        template <typename U>
+        explicit Matrix (const Matrix<U, C>& that) :
+                _m(that.rows()),
+                _rows(that.rows()),
+                _cols(that.columns()) {
+            MATRIX_PROFILE_ALLOC(_rows * _cols * sizeof(T));
+            place_rows(_m, _cols, T());
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(static) if (elements() >= NumaPolicy::grain())
+#endif
+            for (size_type r = 0; r < _rows; r++)
+                if (_cols != 0)
+                    convert_row_into(that[r], _cols, _m[r]);}
 
         // -----------
         // operator []
@@ -379,11 +1050,10 @@ class Matrix {
          * @return a reference of the matrix after addtion.
          */
         Matrix& operator += (const T& rhs) {
-            for (size_type r = 0; r < _m.size(); r++) {
-                for (size_type c = 0; c < _m[0].size(); c++) {
-                    (*this)[r][c] = (*this)[r][c] + rhs;
-                }
-            }
+            if (!intact("operator += (scalar)"))
+                return *this;
+            MATRIX_PROFILE_SCOPE("operator += (scalar)", elements());
+            transform<plus_op>(rhs);
             return *this;}
 
         // -----------
@@ -399,13 +1069,10 @@ class Matrix {
          * @return a reference of the matrix after addtion.
          */
         Matrix& operator += (const Matrix& rhs) {
-            if ((_m.size() != rhs._m.size()) || _m.size() == 0 || _m[0].size() != rhs._m[0].size() || _m[0].size() == 0)
-                throw DimensionException();
-            for (size_type r = 0; r < _m.size(); r++) {
-                for (size_type c = 0; c < _m[0].size(); c++) {
-                    (*this)[r][c] = (*this)[r][c] + rhs[r][c];
-                }
-            }
+            if (!conforms("operator +=", rhs))
+                return *this;
+            MATRIX_PROFILE_SCOPE("operator +=", elements());
+            transform<plus_op>(rhs);
             return *this;
         }
 
@@ -420,11 +1087,10 @@ class Matrix {
          * @return a reference of the matrix after subtraction.
          */
         Matrix& operator -= (const T& rhs) {
-            for (size_type r = 0; r < _m.size(); r++) {
-                for (size_type c = 0; c < _m[0].size(); c++) {
-                    (*this)[r][c] = (*this)[r][c] - rhs;
-                }
-            }
+            if (!intact("operator -= (scalar)"))
+                return *this;
+            MATRIX_PROFILE_SCOPE("operator -= (scalar)", elements());
+            transform<minus_op>(rhs);
             return *this;}
 
         // -----------
@@ -440,13 +1106,10 @@ class Matrix {
          * @return a reference of the matrix after subtraction.
          */
         Matrix& operator -= (const Matrix& rhs) {
-            if ((_m.size() != rhs._m.size()) || _m.size() == 0 || _m[0].size() != rhs._m[0].size() || _m[0].size() == 0)
-                throw DimensionException();
-            for (size_type r = 0; r < _m.size(); r++) {
-                for (size_type c = 0; c < _m[0].size(); c++) {
-                    (*this)[r][c] = (*this)[r][c] - rhs[r][c];
-                }
-            }
+            if (!conforms("operator -=", rhs))
+                return *this;
+            MATRIX_PROFILE_SCOPE("operator -=", elements());
+            transform<minus_op>(rhs);
             return *this;
         }
 
@@ -461,11 +1124,10 @@ class Matrix {
          * @return a reference of the matrix after multiplication.
          */
         Matrix& operator *= (const T& rhs) {
-            for (size_type r = 0; r < _m.size(); r++) {
-                for (size_type c = 0; c < _m[0].size(); c++) {
-                    (*this)[r][c] = (*this)[r][c] * rhs;
-                }
-            }
+            if (!intact("operator *= (scalar)"))
+                return *this;
+            MATRIX_PROFILE_SCOPE("operator *= (scalar)", elements());
+            transform<times_op>(rhs);
             return *this;}
 
         // -----------
@@ -477,29 +1139,117 @@ class Matrix {
          * - the matrices must not be empty.
          * - the number of rows of the rhs matrix must be equal the number of columns of the 
          * - left hand side matrix.
+         * Uses Strassen's method if ProductPolicy::algorithm() says so and the smallest
+         * dimension is at least ProductPolicy::threshold(); see multiply().
          * @param rhs the matrix on the right hand side.
          * @return a reference of the matrix after multiplication.
          */
         Matrix& operator *= (const Matrix& rhs) { 
-            if (_m.size() == 0 || rhs._m.size() == 0) {
-                throw DimensionException();
-            }                
-            else if (_m[0].size() == rhs._m.size() ){
-                Matrix<T> lhs = (*this);
-                for (size_type i = 0; i < _m.size(); i++)  _m[i].resize(rhs._m[0].size(), 0);
-                (*this) *= 0;
-                for (size_type c = 0; c < _m[0].size(); c++) {
-                    for (size_type r = 0; r < _m.size(); r++) {
-                        for (size_type old_r = 0; old_r < rhs._m.size(); old_r++) {
-                            _m[r][c] += (lhs._m[r][old_r] * rhs._m[old_r][c]);
-                        }
-                    }
-                }
+            const bool large = std::min(_rows, std::min(_cols, rhs._cols)) >= ProductPolicy::threshold();
+            return multiply(rhs, ProductPolicy::algorithm() == strassen_product && large ? strassen_product : classical_product);
+        }
+
+        // --------
+        // multiply
+        // --------
+
+        /**
+         * Used to perform matrix multiplication with the given algorithm.
+         * - the matrices must not be empty.
+         * - the number of rows of the rhs matrix must be equal the number of columns of the 
+         * - left hand side matrix.
+         * The sums of products are accumulated in numeric_traits<T>::accumulate_type
+         * (e.g. float in double, int in long). The classical product works one row of the result at
+         * a time, in parallel over the row blocks of place_rows(); Strassen's method (see Strassen.h for its accuracy) is used whenever
+         * the product is at least twice ProductPolicy::cutoff() in every dimension.
+         * The result is built in new rows, which replace those of this matrix at the end.
+         * @param rhs the matrix on the right hand side.
+         * @param algorithm classical_product or strassen_product.
+         * @return a reference of the matrix after multiplication.
+         * @throws bad_alloc leaving this matrix unchanged
+         */
+        Matrix& multiply (const Matrix& rhs, product_algorithm algorithm) { 
+            if (!intact("operator *=") || !rhs.intact("operator *="))
+                return *this;
+            if (C::enabled && (_rows == 0 || rhs._rows == 0 || _cols != rhs._rows)) {
+                C::mismatch("operator *=", _rows, _cols, rhs._rows, rhs._cols);
                 return *this;
             }
-            else {
-                throw DimensionException();
+            MATRIX_PROFILE_SCOPE("operator *=", elements() * rhs._cols);
+            typedef typename numeric_traits<T>::accumulate_type A;
+            const size_type n = rhs._cols;
+            MATRIX_PROFILE_ALLOC(_rows * n * sizeof(T));
+            container_type result(_rows);
+            place_rows(result, n, T());
+            if (n == 0 || _cols == 0) {
+                _m.swap(result);
+                _cols = n;
+                return *this;
             }
+            const size_type levels = strassen_levels(_rows, _cols, n, ProductPolicy::cutoff());
+            if (algorithm == strassen_product && levels != 0) {
+                MATRIX_PROFILE_SCOPE("strassen", elements() * n);
+                const size_type pm = strassen_round(_rows, levels);
+                const size_type pk = strassen_round(_cols, levels);
+                const size_type pn = strassen_round(n,     levels);
+                const size_type pw = strassen_workspace(pm, pk, pn, levels, ProductPolicy::parallel());
+                MATRIX_PROFILE_ALLOC((pm * pk + pk * pn + pm * pn + pw) * sizeof(A));
+                std::vector<A> a(pm * pk);
+                std::vector<A> b(pk * pn);
+                std::vector<A> c(pm * pn);
+                std::vector<A> work(pw);
+                for (size_type r = 0; r < _rows; r++)
+                    convert_row(_m[r], _cols, &a[r * pk]);
+                for (size_type k = 0; k < rhs._rows; k++)
+                    convert_row(rhs._m[k], n, &b[k * pn]);
+                strassen_run(&a[0], pk, &b[0], pn, &c[0], pn, pm, pk, pn, levels, ProductPolicy::parallel(), work.empty() ? 0 : &work[0]);
+#ifdef _OPENMP
+                #pragma omp parallel for schedule(static) if (_rows * n >= NumaPolicy::grain())
+#endif
+                for (size_type r = 0; r < _rows; r++)
+                    convert_row(&c[r * pn], n, result[r]);
+                _m.swap(result);
+                _cols = n;
+                return *this;
+            }
+            MATRIX_PROFILE_ALLOC((rhs.elements() + _cols + n) * sizeof(A));
+            std::vector<A> b(rhs._rows * n);
+            for (size_type k = 0; k < rhs._rows; k++)
+                convert_row(rhs._m[k], n, &b[k * n]);
+            bool failed = false;
+#ifdef _OPENMP
+            #pragma omp parallel if (elements() * n >= NumaPolicy::grain())
+#endif
+            {
+            std::vector<A> a;   // per thread
+            std::vector<A> sum;
+#ifdef _OPENMP
+            #pragma omp for schedule(static)
+#endif
+            for (size_type r = 0; r < _rows; r++) {
+                try {
+                    a.resize(_cols);
+                    sum.assign(n, A());
+                    convert_row(_m[r], _cols, &a[0]);
+                    for (size_type k = 0; k < _cols; k++) {
+                        const A  x = a[k];
+                        const A* y = &b[k * n];
+                        for (size_type c = 0; c < n; c++)
+                            sum[c] += x * y[c];
+                    }
+                    convert_row(&sum[0], n, result[r]);}
+                catch (const std::bad_alloc&) {
+#ifdef _OPENMP
+                    #pragma omp critical (matrix_bad_alloc)
+#endif
+                    failed = true;}
+            }
+            }
+            if (failed)
+                throw std::bad_alloc();
+            _m.swap(result);
+            _cols = n;
+            return *this;
         }
 
         // --
@@ -512,16 +1262,16 @@ class Matrix {
          * @return true of false to indicate whether these two matrices are equal.
          */
         bool eq (const Matrix& rhs) const {
-            if (_m.size() != rhs._m.size()) return false;
+            if (_rows != rhs._rows) return false;
             else {
-                if (_m.size() == 0) return true;
+                if (_rows == 0) return true;
                 else {
-                    if (_m[0].size() != rhs._m[0].size()) return false;
-                    else if (_m[0].size() == 0) return true;
+                    if (_cols != rhs._cols) return false;
+                    else if (_cols == 0) return true;
                 }
             }
-            for (size_type r = 0; r < _m.size(); r++) {
-                for (size_type c = 0; c < _m[0].size(); c++) {
+            for (size_type r = 0; r < _rows; r++) {
+                for (size_type c = 0; c < _cols; c++) {
                     if (_m[r][c] != rhs._m[r][c]) return false;
                 }
             }
@@ -533,10 +1283,18 @@ class Matrix {
 
         /**
          * Used to add a row to the matrix.
-         * @row the row to be added
+         * - the row must have as many columns as the matrix, unless the matrix is empty.
+         * @row the row to be added, a std::vector<T> with any allocator
          */
-        void push_back (std::vector<T> row) {
-            _m.push_back(row);
+        template <typename A>
+        void push_back (const std::vector<T, A>& row) {
+            if (C::enabled && _rows != 0 && row.size() != _cols) {
+                C::mismatch("push_back", _rows, _cols, 1, row.size());
+                return;
+            }
+            _m.push_back(value_type(row.begin(), row.end()));
+            _cols = row.size();
+            ++_rows;
         }
 
         // -----
@@ -579,6 +1337,150 @@ class Matrix {
          * @return the size of the matrix, which is the row number.
          */
         size_type size () const {
-            return _m.size();}};
+            return _rows;}
+
+        // ----
+        // rows
+        // ----
+
+        /**
+         * @return the number of rows of the matrix.
+         */
+        size_type rows () const {
+            return _rows;}
+
+        // -------
+        // columns
+        // -------
+
+        /**
+         * @return the number of columns of the matrix.
+         */
+        size_type columns () const {
+            return _cols;}};
+
+// -------------
+// scalar_result
+// -------------
+
+/**
+ * The type of a Matrix<T, C> combined with a scalar U: Matrix<promote<T, U>::type, C>.
+ * Only defined when both T and U have numeric_traits, so that the mixed scalar
+ * operators below leave every other right hand side, matrices included, alone.
+ */
+template <typename T, typename U, typename C, bool = numeric_traits<T>::numeric && numeric_traits<U>::numeric>
+struct scalar_result {};
+
+template <typename T, typename U, typename C>
+struct scalar_result<T, U, C, true> {
+    typedef Matrix<typename promote<T, U>::type, C> type;};
+
+// -------------------
+// operator + (mixed)
+// -------------------
+
+/**
+ * Used to add two matrices of different element types.
+ * - the matrices must not be empty.
+ * - the matrices must have the same row.
+ * - the matrices must have the same column.
+ * @param lhs the matrix on the left hand side of the equation.
+ * @param rhs the matrix on the right hand side of the equation.
+ * @return a matrix of the promoted element type, e.g. int and double give double.
+ */
+template <typename T, typename U, typename C>
+Matrix<typename promote<T, U>::type, C> operator + (const Matrix<T, C>& lhs, const Matrix<U, C>& rhs) {
+    typedef typename promote<T, U>::type P;
+    Matrix<P, C> result(lhs);
+    return result += Matrix<P, C>(rhs);}
+
+// -------------------
+// operator - (mixed)
+// -------------------
+
+/**
+ * Used to subtract two matrices of different element types.
+ * - the matrices must not be empty.
+ * - the matrices must have the same row.
+ * - the matrices must have the same column.
+ * @param lhs the matrix on the left hand side of the equation.
+ * @param rhs the matrix on the right hand side of the equation.
+ * @return a matrix of the promoted element type.
+ */
+template <typename T, typename U, typename C>
+Matrix<typename promote<T, U>::type, C> operator - (const Matrix<T, C>& lhs, const Matrix<U, C>& rhs) {
+    typedef typename promote<T, U>::type P;
+    Matrix<P, C> result(lhs);
+    return result -= Matrix<P, C>(rhs);}
+
+// -------------------
+// operator * (mixed)
+// -------------------
+
+/**
+ * Used to multiply two matrices of different element types.
+ * - the matrices must not be empty.
+ * - the number of rows of the rhs matrix must be equal the number of columns of the 
+ * - left hand side matrix.
+ * @param lhs the matrix on the left hand side of the equation.
+ * @param rhs the matrix on the right hand side of the equation.
+ * @return a matrix of the promoted element type.
+ */
+template <typename T, typename U, typename C>
+Matrix<typename promote<T, U>::type, C> operator * (const Matrix<T, C>& lhs, const Matrix<U, C>& rhs) {
+    typedef typename promote<T, U>::type P;
+    Matrix<P, C> result(lhs);
+    return result *= Matrix<P, C>(rhs);}
+
+// --------------------------
+// operator + (mixed, scalar)
+// --------------------------
+
+/**
+ * Used to add a scalar of another element type to every element of a matrix,
+ * e.g. Matrix<int> + 0.5 gives a Matrix<double>. A scalar of the element type
+ * itself goes to the operator + of Matrix.
+ * @param lhs the matrix on the left hand side of the equation.
+ * @param rhs the scalar on the right hand side of the equation.
+ * @return a matrix of the promoted element type.
+ */
+template <typename T, typename U, typename C>
+typename scalar_result<T, U, C>::type operator + (const Matrix<T, C>& lhs, const U& rhs) {
+    typedef typename promote<T, U>::type P;
+    typename scalar_result<T, U, C>::type result(lhs);
+    return result += static_cast<P>(rhs);}
+
+// --------------------------
+// operator - (mixed, scalar)
+// --------------------------
+
+/**
+ * Used to subtract a scalar of another element type from every element of a matrix.
+ * @param lhs the matrix on the left hand side of the equation.
+ * @param rhs the scalar on the right hand side of the equation.
+ * @return a matrix of the promoted element type.
+ */
+template <typename T, typename U, typename C>
+typename scalar_result<T, U, C>::type operator - (const Matrix<T, C>& lhs, const U& rhs) {
+    typedef typename promote<T, U>::type P;
+    typename scalar_result<T, U, C>::type result(lhs);
+    return result -= static_cast<P>(rhs);}
+
+// --------------------------
+// operator * (mixed, scalar)
+// --------------------------
+
+/**
+ * Used to multiply every element of a matrix by a scalar of another element type,
+ * e.g. Matrix<int>(2, 2, 3) * 2.5 gives a Matrix<double> of 7.5.
+ * @param lhs the matrix on the left hand side of the equation.
+ * @param rhs the scalar on the right hand side of the equation.
+ * @return a matrix of the promoted element type.
+ */
+template <typename T, typename U, typename C>
+typename scalar_result<T, U, C>::type operator * (const Matrix<T, C>& lhs, const U& rhs) {
+    typedef typename promote<T, U>::type P;
+    typename scalar_result<T, U, C>::type result(lhs);
+    return result *= static_cast<P>(rhs);}
 
 #endif // Matrix_h
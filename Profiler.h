@@ -0,0 +1,331 @@
+// --------------------------
+// projects/matlab/Profiler.h
+// Copyright (C) 2012
+// Glenn P. Downing
+// --------------------------
+
+#ifndef Profiler_h
+#define Profiler_h
+
+/**
+ * Opt-in instrumentation of the Matrix operators and the Matlab functions.
+ *
+ * Compiled out by default: unless MATRIX_PROFILE is defined before Matrix.h is
+ * included, the MATRIX_PROFILE_* macros expand to nothing and their arguments
+ * are never evaluated. With MATRIX_PROFILE defined (requires C++11):
+ *     g++ -std=c++11 -DMATRIX_PROFILE ...
+ *     ...
+ *     Profiler::instance().report(std::cout); // table
+ *     Profiler::instance().trace(file);       // chrome://tracing JSON
+ *
+ * Every operation records its call count, wall time, the number of elements it
+ * processed, the bytes it allocated and the matrix copies it made. Time is
+ * inclusive of nested operations; bytes and copies are charged to the innermost
+ * operation only. Allocations and copies made outside of any operation (e.g. the
+ * by-value argument of operator +) are added up under "(outside operations)",
+ * which counts no calls and traces no events.
+ */
+
+#ifndef MATRIX_PROFILE
+
+#define MATRIX_PROFILE_SCOPE(name, elements)
+#define MATRIX_PROFILE_ALLOC(bytes)
+#define MATRIX_PROFILE_COPY(bytes)
+
+#else
+
+#if __cplusplus < 201103L
+#error "MATRIX_PROFILE requires C++11"
+#endif
+
+// --------
+// includes
+// --------
+
+#include <chrono>     // steady_clock
+#include <cstddef>    // size_t
+#include <functional> // hash
+#include <iomanip>    // setw
+#include <map>        // map
+#include <mutex>      // mutex, lock_guard
+#include <ostream>    // ostream
+#include <string>     // string
+#include <thread>     // this_thread
+#include <vector>     // vector
+
+#ifndef MATRIX_PROFILE_EVENTS
+#define MATRIX_PROFILE_EVENTS 100000 // maximum number of trace events kept
+#endif
+
+// --------
+// Profiler
+// --------
+
+/**
+ * The process-wide store of the per-operation records and the trace events.
+ * Thread-safe.
+ */
+class Profiler {
+    public:
+        // ------
+        // Record
+        // ------
+
+        /**
+         * The accumulated statistics of one operation.
+         */
+        struct Record {
+            std::size_t calls;
+            double      seconds;
+            std::size_t elements;
+            std::size_t bytes;
+            std::size_t copies;
+
+            Record () : calls(0), seconds(0), elements(0), bytes(0), copies(0) {}};
+
+    private:
+        // -----
+        // Event
+        // -----
+
+        struct Event {
+            std::string name;
+            double      start;    // microseconds since the profiler was created
+            double      duration; // microseconds
+            std::size_t thread;
+            std::size_t elements;
+            std::size_t bytes;
+            std::size_t copies;};
+
+        // ----
+        // data
+        // ----
+
+        typedef std::chrono::steady_clock clock_type;
+
+        mutable std::mutex            _lock;
+        clock_type::time_point        _origin;
+        std::map<std::string, Record> _records;
+        std::vector<Event>            _events;
+
+        Profiler () : _origin(clock_type::now()) {}
+
+    public:
+        // --------
+        // instance
+        // --------
+
+        /**
+         * @return the process-wide profiler.
+         */
+        static Profiler& instance () {
+            static Profiler p;
+            return p;}
+
+        // ---
+        // now
+        // ---
+
+        /**
+         * @return microseconds elapsed since the profiler was created.
+         */
+        double now () const {
+            return std::chrono::duration<double, std::micro>(clock_type::now() - _origin).count();}
+
+        // ------
+        // record
+        // ------
+
+        /**
+         * Used to account for one completed call of an operation.
+         * @param name the operation.
+         * @param start the start time as returned by now().
+         * @param elements the number of elements processed.
+         * @param bytes the number of bytes allocated.
+         * @param copies the number of matrix copies made.
+         */
+        void record (const char* name, double start, std::size_t elements, std::size_t bytes, std::size_t copies) {
+            const double duration = now() - start;
+            std::lock_guard<std::mutex> guard(_lock);
+            Record& r = _records[name];
+            ++r.calls;
+            r.seconds  += duration / 1e6;
+            r.elements += elements;
+            r.bytes    += bytes;
+            r.copies   += copies;
+            if (_events.size() < MATRIX_PROFILE_EVENTS) {
+                Event e = {name, start, duration, std::hash<std::thread::id>()(std::this_thread::get_id()), elements, bytes, copies};
+                _events.push_back(e);}}
+
+        // ------
+        // charge
+        // ------
+
+        /**
+         * Used to account for bytes and copies that belong to no call: they are
+         * added to the statistics of the name without counting a call or an event.
+         * @param name the operation.
+         * @param bytes the number of bytes allocated.
+         * @param copies the number of matrix copies made.
+         */
+        void charge (const char* name, std::size_t bytes, std::size_t copies) {
+            std::lock_guard<std::mutex> guard(_lock);
+            Record& r = _records[name];
+            r.bytes  += bytes;
+            r.copies += copies;}
+
+        // ---
+        // get
+        // ---
+
+        /**
+         * @param name the operation.
+         * @return a snapshot of the statistics of the operation (all zeros if it never ran).
+         */
+        Record get (const std::string& name) const {
+            std::lock_guard<std::mutex> guard(_lock);
+            std::map<std::string, Record>::const_iterator i = _records.find(name);
+            return i == _records.end() ? Record() : i->second;}
+
+        // -----
+        // reset
+        // -----
+
+        /**
+         * Used to discard all the records and events.
+         */
+        void reset () {
+            std::lock_guard<std::mutex> guard(_lock);
+            _records.clear();
+            _events.clear();}
+
+        // ------
+        // report
+        // ------
+
+        /**
+         * Used to write one line per operation: calls, total and mean time,
+         * elements, bytes allocated and copies.
+         * @param out the stream to write to.
+         */
+        void report (std::ostream& out) const {
+            std::lock_guard<std::mutex> guard(_lock);
+            out << std::left  << std::setw(24) << "operation"
+                << std::right << std::setw(10) << "calls"
+                << std::setw(14) << "total ms"
+                << std::setw(12) << "mean us"
+                << std::setw(16) << "elements"
+                << std::setw(16) << "bytes"
+                << std::setw(10) << "copies" << "\n";
+            std::map<std::string, Record>::const_iterator i = _records.begin();
+            for (; i != _records.end(); ++i) {
+                const Record& r = i->second;
+                out << std::left  << std::setw(24) << i->first
+                    << std::right << std::setw(10) << r.calls
+                    << std::setw(14) << std::fixed << std::setprecision(3) << r.seconds * 1e3
+                    << std::setw(12) << (r.calls ? r.seconds * 1e6 / r.calls : 0.0)
+                    << std::setw(16) << r.elements
+                    << std::setw(16) << r.bytes
+                    << std::setw(10) << r.copies << "\n";}}
+
+        // -----
+        // trace
+        // -----
+
+        /**
+         * Used to write the events in the Chrome trace event format
+         * (chrome://tracing, Perfetto).
+         * @param out the stream to write to.
+         */
+        void trace (std::ostream& out) const {
+            std::lock_guard<std::mutex> guard(_lock);
+            out << "{\"traceEvents\":[";
+            for (std::size_t i = 0; i < _events.size(); ++i) {
+                const Event& e = _events[i];
+                out << (i ? ",\n" : "\n")
+                    << "{\"name\":\"" << e.name << "\",\"cat\":\"matrix\",\"ph\":\"X\""
+                    << ",\"ts\":"  << std::fixed << std::setprecision(3) << e.start
+                    << ",\"dur\":" << e.duration
+                    << ",\"pid\":1,\"tid\":" << e.thread
+                    << ",\"args\":{\"elements\":" << e.elements
+                    << ",\"bytes\":" << e.bytes
+                    << ",\"copies\":" << e.copies << "}}";}
+            out << "\n],\"displayTimeUnit\":\"ns\"}\n";}};
+
+// ------------
+// ProfileScope
+// ------------
+
+/**
+ * Times one operation from construction to destruction and collects the
+ * allocations and copies made while it is the innermost scope of its thread.
+ */
+class ProfileScope {
+    private:
+        const char*   _name;
+        double        _start;
+        std::size_t   _elements;
+        std::size_t   _bytes;
+        std::size_t   _copies;
+        ProfileScope* _parent;
+
+        static ProfileScope*& current () {
+            static thread_local ProfileScope* p = 0;
+            return p;}
+
+        ProfileScope            (const ProfileScope&);
+        ProfileScope& operator = (const ProfileScope&);
+
+    public:
+        ProfileScope (const char* name, std::size_t elements) :
+                _name(name),
+                _start(Profiler::instance().now()),
+                _elements(elements),
+                _bytes(0),
+                _copies(0),
+                _parent(current()) {
+            current() = this;}
+
+        ~ProfileScope () {
+            current() = _parent;
+            Profiler::instance().record(_name, _start, _elements, _bytes, _copies);}
+
+        // --------
+        // allocate
+        // --------
+
+        /**
+         * Used to charge an allocation to the innermost scope.
+         * @param bytes the number of bytes allocated.
+         */
+        static void allocate (std::size_t bytes) {
+            if (ProfileScope* s = current())
+                s->_bytes += bytes;
+            else
+                Profiler::instance().charge("(outside operations)", bytes, 0);}
+
+        // ----
+        // copy
+        // ----
+
+        /**
+         * Used to charge a matrix copy to the innermost scope.
+         * @param bytes the number of bytes copied (and allocated).
+         */
+        static void copy (std::size_t bytes) {
+            if (ProfileScope* s = current()) {
+                s->_bytes += bytes;
+                ++s->_copies;}
+            else
+                Profiler::instance().charge("(outside operations)", bytes, 1);}};
+
+#define MATRIX_PROFILE_CONCAT_(a, b) a ## b
+#define MATRIX_PROFILE_CONCAT(a, b)  MATRIX_PROFILE_CONCAT_(a, b)
+
+#define MATRIX_PROFILE_SCOPE(name, elements) ProfileScope MATRIX_PROFILE_CONCAT(profile_scope_, __LINE__)(name, elements)
+#define MATRIX_PROFILE_ALLOC(bytes)          ProfileScope::allocate(bytes)
+#define MATRIX_PROFILE_COPY(bytes)           ProfileScope::copy(bytes)
+
+#endif // MATRIX_PROFILE
+
+#endif // Profiler_h
@@ -0,0 +1,285 @@
+// --------------------------
+// projects/matlab/Strassen.h
+// Copyright (C) 2012
+// Glenn P. Downing
+// --------------------------
+
+#ifndef Strassen_h
+#define Strassen_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // fill, min
+#include <cstddef>   // size_t
+
+/**
+ * Strassen's recursive matrix multiplication, for very large products.
+ *
+ * Each level splits the operands into quadrants and forms the product from 7
+ * quadrant products instead of 8, so L levels do (7/8)^L of the flops of the
+ * classical product (L = 3 saves about 33%). Below the cutoff the quadrants are
+ * multiplied by a blocked classical kernel. The operands are zero-padded so that
+ * every dimension halves evenly L times, and all the temporaries of the recursion
+ * come from one workspace allocated up front (see strassen_workspace()). The 7
+ * products of the top parallel levels run as OpenMP tasks (compile with -fopenmp).
+ *
+ * Accuracy: Strassen's method is only normwise stable. With unit roundoff u and
+ * a classical cutoff n0, for n x n operands (Higham, Accuracy and Stability of
+ * Numerical Algorithms, 2nd ed., Theorem 23.2)
+ *     max|C - fl(C)| <= [(n/n0)^log2(12) (n0^2 + 5 n0) - 5n] u max|A| max|B|
+ * whereas the classical product satisfies |C - fl(C)| <= n u |A||B| element by
+ * element. Elements of C much smaller than max|A| max|B| may therefore lose
+ * correspondingly more relative accuracy; integer products are exact (barring
+ * overflow).
+ */
+
+// -----------------
+// product_algorithm
+// -----------------
+
+enum product_algorithm {
+    classical_product,
+    strassen_product};
+
+// -------------
+// ProductPolicy
+// -------------
+
+/**
+ * The process-wide choice of the algorithm used by Matrix::operator *=.
+ * Set it before starting threads; it is read on every product.
+ */
+struct ProductPolicy {
+    /**
+     * @return the algorithm used by operator *= (classical_product by default).
+     */
+    static product_algorithm& algorithm () {
+        static product_algorithm a = classical_product;
+        return a;}
+
+    /**
+     * @return the smallest dimension of a product for operator *= to use Strassen (4096 by default).
+     */
+    static std::size_t& threshold () {
+        static std::size_t t = 4096;
+        return t;}
+
+    /**
+     * @return the dimension below which the recursion switches to the classical kernel (512 by default).
+     */
+    static std::size_t& cutoff () {
+        static std::size_t c = 512;
+        return c;}
+
+    /**
+     * @return how many levels of the recursion run their 7 products in parallel
+     * (1 by default with OpenMP, 0 without, so no workspace is set aside for them).
+     */
+    static std::size_t& parallel () {
+#ifdef _OPENMP
+        static std::size_t p = 1;
+#else
+        static std::size_t p = 0;
+#endif
+        return p;}};
+
+// ---------------
+// strassen_levels
+// ---------------
+
+/**
+ * @param m the rows of the lhs.
+ * @param k the columns of the lhs (rows of the rhs).
+ * @param n the columns of the rhs.
+ * @param cutoff the dimension below which the classical kernel is used.
+ * @return the number of levels of recursion, 0 if the product is too small.
+ */
+inline std::size_t strassen_levels (std::size_t m, std::size_t k, std::size_t n, std::size_t cutoff) {
+    const std::size_t d = std::min(m, std::min(k, n));
+    std::size_t levels = 0;
+    while ((d >> (levels + 1)) >= cutoff && (d >> (levels + 1)) != 0)
+        ++levels;
+    return levels;}
+
+// --------------
+// strassen_round
+// --------------
+
+/**
+ * @return d rounded up to a multiple of 2^levels.
+ */
+inline std::size_t strassen_round (std::size_t d, std::size_t levels) {
+    const std::size_t q = std::size_t(1) << levels;
+    return (d + q - 1) / q * q;}
+
+// ------------------
+// strassen_workspace
+// ------------------
+
+/**
+ * @param m the (padded) rows of the lhs.
+ * @param k the (padded) columns of the lhs.
+ * @param n the (padded) columns of the rhs.
+ * @param levels the number of levels of recursion.
+ * @param parallel the number of top levels whose 7 products run in parallel.
+ * @return the number of elements of workspace strassen() needs.
+ */
+inline std::size_t strassen_workspace (std::size_t m, std::size_t k, std::size_t n, std::size_t levels, std::size_t parallel) {
+    if (levels == 0)
+        return 0;
+    const std::size_t mh   = m / 2;
+    const std::size_t kh   = k / 2;
+    const std::size_t nh   = n / 2;
+    const std::size_t slot = mh * kh + kh * nh + mh * nh + strassen_workspace(mh, kh, nh, levels - 1, parallel ? parallel - 1 : 0);
+    return parallel ? 7 * slot : slot;}
+
+// --------------
+// product_kernel
+// --------------
+
+/**
+ * Used to compute c = a * b classically, in blocks that stay in cache.
+ * @param a the m x k lhs, rows lda apart.
+ * @param b the k x n rhs, rows ldb apart.
+ * @param c the m x n result, rows ldc apart.
+ */
+template <typename A>
+void product_kernel (const A* a, std::size_t lda, const A* b, std::size_t ldb, A* c, std::size_t ldc,
+                     std::size_t m, std::size_t k, std::size_t n) {
+    const std::size_t kb = 128;
+    const std::size_t nb = 512;
+    for (std::size_t i = 0; i < m; ++i)
+        std::fill(c + i * ldc, c + i * ldc + n, A());
+    for (std::size_t kk = 0; kk < k; kk += kb) {
+        const std::size_t ke = std::min(k, kk + kb);
+        for (std::size_t jj = 0; jj < n; jj += nb) {
+            const std::size_t je = std::min(n, jj + nb);
+            for (std::size_t i = 0; i < m; ++i) {
+                A* ci = c + i * ldc;
+                for (std::size_t p = kk; p < ke; ++p) {
+                    const A  x  = a[i * lda + p];
+                    const A* bp = b + p * ldb;
+                    for (std::size_t j = jj; j < je; ++j)
+                        ci[j] += x * bp[j];}}}}}
+
+// ------------
+// strassen_sum
+// ------------
+
+/**
+ * Used to compute z = x + sign * y over a rows x cols block.
+ */
+template <typename A>
+void strassen_sum (const A* x, std::size_t ldx, const A* y, std::size_t ldy, int sign,
+                   A* z, std::size_t ldz, std::size_t rows, std::size_t cols) {
+    for (std::size_t i = 0; i < rows; ++i) {
+        const A* xi = x + i * ldx;
+        const A* yi = y + i * ldy;
+        A*       zi = z + i * ldz;
+        if (sign > 0)
+            for (std::size_t j = 0; j < cols; ++j) zi[j] = xi[j] + yi[j];
+        else
+            for (std::size_t j = 0; j < cols; ++j) zi[j] = xi[j] - yi[j];}}
+
+// --------
+// strassen
+// --------
+
+/**
+ * Used to compute c = a * b with Strassen's method.
+ * - m, k and n must be multiples of 2^levels.
+ * @param a the m x k lhs, rows lda apart.
+ * @param b the k x n rhs, rows ldb apart.
+ * @param c the m x n result, rows ldc apart.
+ * @param levels the number of levels of recursion.
+ * @param parallel the number of top levels whose 7 products run as OpenMP tasks.
+ * @param work strassen_workspace(m, k, n, levels, parallel) elements.
+ */
+template <typename A>
+void strassen (const A* a, std::size_t lda, const A* b, std::size_t ldb, A* c, std::size_t ldc,
+               std::size_t m, std::size_t k, std::size_t n, std::size_t levels, std::size_t parallel, A* work) {
+    if (levels == 0) {
+        product_kernel(a, lda, b, ldb, c, ldc, m, k, n);
+        return;}
+
+    // The 7 products: lhs quadrants, lhs sign, rhs quadrants, rhs sign
+    // (quadrants 0 = 11, 1 = 12, 2 = 21, 3 = 22; sign 0 = single quadrant),
+    // then the sign each one is added to c11, c12, c21, c22 with.
+    static const int table[7][10] = {
+        {0, 3, +1,   0, 3, +1,   +1,  0,  0, +1},  // M1 = (A11 + A22)(B11 + B22)
+        {2, 3, +1,   0, 0,  0,    0,  0, +1, -1},  // M2 = (A21 + A22) B11
+        {0, 0,  0,   1, 3, -1,    0, +1,  0, +1},  // M3 = A11 (B12 - B22)
+        {3, 3,  0,   2, 0, -1,   +1,  0, +1,  0},  // M4 = A22 (B21 - B11)
+        {0, 1, +1,   3, 3,  0,   -1, +1,  0,  0},  // M5 = (A11 + A12) B22
+        {2, 0, -1,   0, 1, +1,    0,  0,  0, +1},  // M6 = (A21 - A11)(B11 + B12)
+        {1, 3, -1,   2, 3, +1,   +1,  0,  0,  0}}; // M7 = (A12 - A22)(B21 + B22)
+
+    const std::size_t mh = m / 2;
+    const std::size_t kh = k / 2;
+    const std::size_t nh = n / 2;
+    const A* aq[4] = {a, a + kh, a + mh * lda, a + mh * lda + kh};
+    const A* bq[4] = {b, b + nh, b + kh * ldb, b + kh * ldb + nh};
+    A*       cq[4] = {c, c + nh, c + mh * ldc, c + mh * ldc + nh};
+    const std::size_t slot = strassen_workspace(m, k, n, levels, parallel) / (parallel ? 7 : 1);
+
+    for (std::size_t i = 0; i < m; ++i)
+        std::fill(c + i * ldc, c + i * ldc + n, A());
+
+    for (int t = 0; t < 7; ++t) {
+        A* s = work + (parallel ? t * slot : 0); // mh x kh
+        A* u = s + mh * kh;                       // kh x nh
+        A* p = u + kh * nh;                       // mh x nh
+#ifdef _OPENMP
+        #pragma omp task if (parallel != 0) firstprivate(t, s, u, p)
+#endif
+        {
+        const int* e = table[t];
+        const A*   x = aq[e[0]];
+        std::size_t ldx = lda;
+        if (e[2] != 0) {
+            strassen_sum(aq[e[0]], lda, aq[e[1]], lda, e[2], s, kh, mh, kh);
+            x   = s;
+            ldx = kh;}
+        const A*   y = bq[e[3]];
+        std::size_t ldy = ldb;
+        if (e[5] != 0) {
+            strassen_sum(bq[e[3]], ldb, bq[e[4]], ldb, e[5], u, nh, kh, nh);
+            y   = u;
+            ldy = nh;}
+        strassen(x, ldx, y, ldy, p, nh, mh, kh, nh, levels - 1, parallel ? parallel - 1 : 0, p + mh * nh);
+        }
+        if (parallel == 0)
+            for (int q = 0; q < 4; ++q)
+                if (table[t][6 + q] != 0)
+                    strassen_sum(cq[q], ldc, p, nh, table[t][6 + q], cq[q], ldc, mh, nh);}
+
+    if (parallel != 0) {
+#ifdef _OPENMP
+        #pragma omp taskwait
+#endif
+        for (int t = 0; t < 7; ++t) {
+            A* p = work + t * slot + mh * kh + kh * nh;
+            for (int q = 0; q < 4; ++q)
+                if (table[t][6 + q] != 0)
+                    strassen_sum(cq[q], ldc, p, nh, table[t][6 + q], cq[q], ldc, mh, nh);}}}
+
+// ------------
+// strassen_run
+// ------------
+
+/**
+ * Used to start strassen() inside an OpenMP parallel region, so that its tasks
+ * have threads to run on.
+ */
+template <typename A>
+void strassen_run (const A* a, std::size_t lda, const A* b, std::size_t ldb, A* c, std::size_t ldc,
+                   std::size_t m, std::size_t k, std::size_t n, std::size_t levels, std::size_t parallel, A* work) {
+#ifdef _OPENMP
+    #pragma omp parallel if (parallel != 0)
+    #pragma omp single
+#endif
+    strassen(a, lda, b, ldb, c, ldc, m, k, n, levels, parallel, work);}
+
+#endif // Strassen_h
@@ -0,0 +1,147 @@
+// -----------------------------
+// projects/matlab/TestAsync.c++
+// Copyright (C) 2012
+// Glenn P. Downing
+// -----------------------------
+
+/**
+ * To test the program:
+ *     g++ -std=c++11 -pedantic -pthread -lcppunit -ldl -Wall TestAsync.c++ -o TestAsync.app
+ *     valgrind TestAsync.app >& TestAsync.out
+ */
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // max
+#include <atomic>    // atomic
+#include <chrono>    // milliseconds
+#include <thread>    // this_thread
+
+#include "cppunit/extensions/HelperMacros.h" // CPPUNIT_TEST, CPPUNIT_TEST_SUITE, CPPUNIT_TEST_SUITE_END
+#include "cppunit/TestFixture.h"             // TestFixture
+#include "cppunit/TextTestRunner.h"          // TestRunner
+
+#include "Matrix.h"
+#include "Matlab.h"
+#include "Async.h"
+
+// ---------
+// TestAsync
+// ---------
+
+struct TestAsync : CppUnit::TestFixture {
+    // ------------
+    // test_launch1
+    // ------------
+
+    void test_launch1 () {
+        Future< Matrix<int> > x = launch([] {return Matrix<int>(2, 3, 4);});
+        CPPUNIT_ASSERT(x.get().eq(Matrix<int>(2, 3, 4)));
+        CPPUNIT_ASSERT(x.ready());}
+
+    // ------------
+    // test_launch2
+    // ------------
+
+    void test_launch2 () {
+        Executor e(2);
+        std::atomic<bool> second(false);
+        Future<bool> x = launch([&second] {
+            for (int i = 0; i < 5000 && !second; ++i)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return bool(second);}, e);
+        Future<bool> y = launch([&second] {second = true; return true;}, e);
+        CPPUNIT_ASSERT(y.get());
+        CPPUNIT_ASSERT(x.get());}
+
+    // ----------
+    // test_then1
+    // ----------
+
+    void test_then1 () {
+        Future< Matrix<int> > x = launch([] {return Matrix<int>(2, 3, 1);});
+        Future< Matrix<int> > y = launch([] {return Matrix<int>(3, 2, 2);});
+        Future< Matrix<int> > z = transpose(x * y + ready(Matrix<int>(2, 2, 1)));
+        CPPUNIT_ASSERT(z.get().eq(Matrix<int>(2, 2, 7)));}
+
+    // ----------
+    // test_then2
+    // ----------
+
+    void test_then2 () {
+        Future<int> x = ready(2);
+        Future<int> y = launch([] {return 3;});
+        Future<double> z = ready(0.5);
+        Future<double> w = then([] (int a, int b, double c) {return a * b * c;}, x, y, z);
+        CPPUNIT_ASSERT(w.get() == 3.0);}
+
+    // ----------
+    // test_then3
+    // ----------
+
+    void test_then3 () {
+        Future< Matrix<int> > x = ready(Matrix<int>(2, 3, 1));
+        Future< Matrix<int> > y = ready(Matrix<int>(2, 3, 1));
+        Future< Matrix<int> > z = mtimes(x, y, classical_product);
+        Future< Matrix<int> > w = z - x;
+        try {
+            w.get();
+            CPPUNIT_ASSERT(false);
+        }
+        catch (DimensionException& e) {
+            CPPUNIT_ASSERT(true);
+        }
+    }
+
+    // ----------
+    // test_then4
+    // ----------
+
+    void test_then4 () {
+        Executor e(1);
+        Future<std::thread::id> pool = launch([] {return std::this_thread::get_id();}, e);
+        Future< Matrix<int> >   x    = launch([] {return Matrix<int>(2, 2, 1);}, e);
+        Future< Matrix<int> >   y    = x + ready(Matrix<int>(2, 2, 2));
+        Future<std::thread::id> z    = then([] (const Matrix<int>&) {return std::this_thread::get_id();}, y);
+        Future<std::thread::id> w    = then(Executor::instance(), [] (const Matrix<int>&) {return std::this_thread::get_id();}, y);
+        CPPUNIT_ASSERT(y.executor() == &e);
+        CPPUNIT_ASSERT(z.get() == pool.get());
+        CPPUNIT_ASSERT(w.get() != pool.get());
+        CPPUNIT_ASSERT(y.get().eq(Matrix<int>(2, 2, 3)));
+#ifdef _OPENMP
+        Executor f(2);
+        const int share = launch([] {return omp_get_max_threads();}, f).get();
+        CPPUNIT_ASSERT(share == std::max(1, omp_get_max_threads() / 2));
+#endif
+        }
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestAsync);
+    CPPUNIT_TEST(test_launch1);
+    CPPUNIT_TEST(test_launch2);
+    CPPUNIT_TEST(test_then1);
+    CPPUNIT_TEST(test_then2);
+    CPPUNIT_TEST(test_then3);
+    CPPUNIT_TEST(test_then4);
+    CPPUNIT_TEST_SUITE_END();};
+
+// ----
+// main
+// ----
+
+int main () {
+    using namespace std;
+    ios_base::sync_with_stdio(false); // turn off synchronization with C I/O
+    cout << "TestAsync.c++" << endl;
+
+    CppUnit::TextTestRunner tr;
+    tr.addTest(TestAsync::suite());
+    tr.run();
+
+    cout << "Done." << endl;
+    return 0;}
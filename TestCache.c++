@@ -0,0 +1,244 @@
+// -----------------------------
+// projects/matlab/TestCache.c++
+// Copyright (C) 2012
+// Glenn P. Downing
+// -----------------------------
+
+/**
+ * To test the program:
+ *     g++ -std=c++11 -pedantic -pthread -lcppunit -ldl -Wall TestCache.c++ -o TestCache.app
+ *     valgrind TestCache.app >& TestCache.out
+ */
+
+// --------
+// includes
+// --------
+
+#include <cstring>  // memcmp, memcpy
+#include <stdlib.h> // mkdtemp, system
+#include <string>   // string
+
+#include "cppunit/extensions/HelperMacros.h" // CPPUNIT_TEST, CPPUNIT_TEST_SUITE, CPPUNIT_TEST_SUITE_END
+#include "cppunit/TestFixture.h"             // TestFixture
+#include "cppunit/TextTestRunner.h"          // TestRunner
+
+#include "Matrix.h"
+#include "Matlab.h"
+#include "Cache.h"
+
+// ---------
+// TestCache
+// ---------
+
+struct TestCache : CppUnit::TestFixture {
+    std::string directory;
+
+    void setUp () {
+        char name[] = "/tmp/TestCache.XXXXXX";
+        CPPUNIT_ASSERT(mkdtemp(name) != 0);
+        directory = name;}
+
+    void tearDown () {
+        const std::string command = "rm -rf " + directory;
+        CPPUNIT_ASSERT(system(command.c_str()) == 0);}
+
+    // ----------
+    // test_hash1
+    // ----------
+
+    void test_hash1 () {
+        Matrix<int> x(3, 4, 7);
+        Matrix<int> y(3, 4, 7);
+        CPPUNIT_ASSERT(content_hash(x) == content_hash(y));
+        y[2][3] = 8;
+        CPPUNIT_ASSERT(content_hash(x) != content_hash(y));
+        CPPUNIT_ASSERT(content_hash(x) != content_hash(Matrix<int>(4, 3, 7)));
+        CPPUNIT_ASSERT(content_hash(Matrix<bool>(2, 2, true)) != content_hash(Matrix<bool>(2, 2, false)));
+        CPPUNIT_ASSERT(content_hash(2) != content_hash(3));}
+
+    // ----------
+    // test_hash2
+    // ----------
+
+    void test_hash2 () {
+        unsigned char bytes[100];
+        for (int i = 0; i < 100; i++)
+            bytes[i] = static_cast<unsigned char>(i * 37 + 11);
+        for (std::size_t n = 0; n <= 100; n++) {
+            const std::uint64_t whole = ContentHash().update(bytes, n).digest();
+            for (std::size_t k = 0; k <= n; k += 7) {
+                ContentHash h;
+                h.update(bytes, k).update(bytes + k, n - k);
+                CPPUNIT_ASSERT(h.digest() == whole);}
+            CPPUNIT_ASSERT(n == 0 || whole != ContentHash().update(bytes, n - 1).digest());}}
+
+    // ----------
+    // test_hash3
+    // ----------
+
+    void test_hash3 () {
+        Matrix<int>   x(2, 2, 0x3f800000);
+        Matrix<float> y(2, 2, 1.0f);
+        CPPUNIT_ASSERT(std::memcmp(&x[0][0], &y[0][0], sizeof(int)) == 0);
+        CPPUNIT_ASSERT(content_hash(x) != content_hash(y));
+        CPPUNIT_ASSERT(content_hash(1) != content_hash(1u));
+        MatrixCache cache;
+        int calls = 0;
+        const auto twice  = [&calls] (const Matrix<int>& a)   {++calls; return Matrix<double>(a) * 2.0;};
+        const auto twicef = [&calls] (const Matrix<float>& a) {++calls; return Matrix<double>(a) * 2.0;};
+        CPPUNIT_ASSERT(memoize(cache, "twice", twice,  x).eq(Matrix<double>(2, 2, 2.0 * 0x3f800000)));
+        CPPUNIT_ASSERT(memoize(cache, "twice", twicef, y).eq(Matrix<double>(2, 2, 2.0)));
+        CPPUNIT_ASSERT(calls == 2);}
+
+    // ---------------
+    // test_serialize1
+    // ---------------
+
+    void test_serialize1 () {
+        Matrix<double> x(2, 3, 1.5);
+        x[1][2] = -4;
+        Matrix<double> y;
+        CPPUNIT_ASSERT(cache_deserialize(cache_serialize(x), y));
+        CPPUNIT_ASSERT(y.eq(x));
+        Matrix<bool> z = x == y;
+        Matrix<bool> w;
+        CPPUNIT_ASSERT(cache_deserialize(cache_serialize(z), w));
+        CPPUNIT_ASSERT(w.eq(z));
+        Matrix<int> v(1, 1, 9);
+        CPPUNIT_ASSERT(!cache_deserialize(cache_serialize(x), v));
+        CPPUNIT_ASSERT(v.eq(Matrix<int>(1, 1, 9)));}
+
+    // ---------------
+    // test_serialize2
+    // ---------------
+
+    void test_serialize2 () {
+        std::string bytes = cache_serialize(Matrix<double>(2, 3, 1.0));
+        std::uint64_t header[3];
+        std::memcpy(header, bytes.data(), sizeof(header));
+        header[0] = (std::uint64_t(1) << 60) + 1;           // header[0] * header[1] * 8 wraps to 48
+        header[1] = 6;
+        std::memcpy(&bytes[0], header, sizeof(header));
+        Matrix<double> x(1, 1, 5.0);
+        CPPUNIT_ASSERT(!cache_deserialize(bytes, x));
+        header[0] = 2;
+        header[1] = 0;
+        std::memcpy(&bytes[0], header, sizeof(header));
+        CPPUNIT_ASSERT(!cache_deserialize(bytes, x));
+        CPPUNIT_ASSERT(x.eq(Matrix<double>(1, 1, 5.0)));}
+
+    // -------------
+    // test_memoize1
+    // -------------
+
+    void test_memoize1 () {
+        MatrixCache cache;
+        int calls = 0;
+        const auto product = [&calls] (const Matrix<int>& a, const Matrix<int>& b) {++calls; return a * b;};
+        Matrix<int> x(2, 3, 1);
+        Matrix<int> y(3, 2, 2);
+        CPPUNIT_ASSERT(memoize(cache, "product", product, x, y).eq(Matrix<int>(2, 2, 6)));
+        CPPUNIT_ASSERT(memoize(cache, "product", product, x, y).eq(Matrix<int>(2, 2, 6)));
+        CPPUNIT_ASSERT(calls == 1);
+        x[0][0] = 2;
+        Matrix<int> z = memoize(cache, "product", product, x, y);
+        CPPUNIT_ASSERT(calls == 2);
+        CPPUNIT_ASSERT(z[0][0] == 8 && z[1][1] == 6);
+        CPPUNIT_ASSERT(cache.statistics().hits == 1 && cache.statistics().misses == 2);}
+
+    // -------------
+    // test_memoize2
+    // -------------
+
+    void test_memoize2 () {
+        MatrixCache cache;
+        int calls = 0;
+        const auto scale = [&calls] (const Matrix<double>& a, int k) {++calls; return a * double(k);};
+        Matrix<double> x(2, 2, 1.0);
+        memoize(cache, "scale", scale, x, 2);
+        memoize(cache, "scale", scale, x, 3);
+        memoize(cache, "twice", scale, x, 2);
+        CPPUNIT_ASSERT(calls == 3);
+        CPPUNIT_ASSERT(memoize(cache, "scale", scale, x, 3).eq(Matrix<double>(2, 2, 3.0)));
+        CPPUNIT_ASSERT(calls == 3);}
+
+    // ---------
+    // test_lru1
+    // ---------
+
+    void test_lru1 () {
+        const std::size_t entry = cache_serialize(Matrix<int>(4, 4, 0)).size();
+        MatrixCache cache(2 * entry);
+        int calls = 0;
+        const auto negate = [&calls] (const Matrix<int>& a) {++calls; return a * -1;};
+        Matrix<int> x(4, 4, 1);
+        Matrix<int> y(4, 4, 2);
+        Matrix<int> z(4, 4, 3);
+        memoize(cache, "negate", negate, x);
+        memoize(cache, "negate", negate, y);
+        memoize(cache, "negate", negate, x);  // x is now the most recently used
+        memoize(cache, "negate", negate, z);  // evicts y
+        CPPUNIT_ASSERT(calls == 3);
+        CPPUNIT_ASSERT(cache.bytes() == 2 * entry);
+        memoize(cache, "negate", negate, x);
+        CPPUNIT_ASSERT(calls == 3);
+        memoize(cache, "negate", negate, y);
+        CPPUNIT_ASSERT(calls == 4);
+        CPPUNIT_ASSERT(cache.statistics().evictions == 2);}
+
+    // -----------
+    // test_spill1
+    // -----------
+
+    void test_spill1 () {
+        const std::size_t entry = cache_serialize(Matrix<int>(4, 4, 0)).size();
+        int calls = 0;
+        const auto negate = [&calls] (const Matrix<int>& a) {++calls; return a * -1;};
+        Matrix<int> x(4, 4, 1);
+        Matrix<int> y(4, 4, 2);
+        {
+        MatrixCache cache(entry, directory);
+        memoize(cache, "negate", negate, x);
+        memoize(cache, "negate", negate, y);                // spills x
+        CPPUNIT_ASSERT(cache.statistics().spills == 1);
+        CPPUNIT_ASSERT(memoize(cache, "negate", negate, x).eq(Matrix<int>(4, 4, -1)));
+        CPPUNIT_ASSERT(cache.statistics().disk_hits == 1);
+        CPPUNIT_ASSERT(calls == 2);
+        }                                                   // flushes
+        MatrixCache next(entry, directory);
+        CPPUNIT_ASSERT(memoize(next, "negate", negate, y).eq(Matrix<int>(4, 4, -2)));
+        CPPUNIT_ASSERT(memoize(next, "negate", negate, x).eq(Matrix<int>(4, 4, -1)));
+        CPPUNIT_ASSERT(calls == 2);
+        CPPUNIT_ASSERT(next.statistics().disk_hits == 2);}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestCache);
+    CPPUNIT_TEST(test_hash1);
+    CPPUNIT_TEST(test_hash2);
+    CPPUNIT_TEST(test_hash3);
+    CPPUNIT_TEST(test_serialize1);
+    CPPUNIT_TEST(test_serialize2);
+    CPPUNIT_TEST(test_memoize1);
+    CPPUNIT_TEST(test_memoize2);
+    CPPUNIT_TEST(test_lru1);
+    CPPUNIT_TEST(test_spill1);
+    CPPUNIT_TEST_SUITE_END();};
+
+// ----
+// main
+// ----
+
+int main () {
+    using namespace std;
+    ios_base::sync_with_stdio(false); // turn off synchronization with C I/O
+    cout << "TestCache.c++" << endl;
+
+    CppUnit::TextTestRunner tr;
+    tr.addTest(TestCache::suite());
+    tr.run();
+
+    cout << "Done." << endl;
+    return 0;}
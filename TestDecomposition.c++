@@ -0,0 +1,331 @@
+// -------------------------------------
+// projects/matlab/TestDecomposition.c++
+// Copyright (C) 2012
+// Glenn P. Downing
+// -------------------------------------
+
+/**
+ * To test the program:
+ *     g++ -ansi -pedantic -fopenmp -lcppunit -ldl -Wall TestDecomposition.c++ -o TestDecomposition.app
+ *     valgrind TestDecomposition.app >& TestDecomposition.out
+ */
+
+// --------
+// includes
+// --------
+
+#include <cmath>  // cos, fabs, sin, sqrt
+#include <limits> // numeric_limits
+
+#include "cppunit/extensions/HelperMacros.h" // CPPUNIT_TEST, CPPUNIT_TEST_SUITE, CPPUNIT_TEST_SUITE_END
+#include "cppunit/TestFixture.h"             // TestFixture
+#include "cppunit/TextTestRunner.h"          // TestRunner
+
+#include "Matrix.h"
+#include "Matlab.h"
+#include "Decomposition.h"
+
+// -----------------
+// TestDecomposition
+// -----------------
+
+struct TestDecomposition : CppUnit::TestFixture {
+    /**
+     * @return the largest difference between the elements of x and y.
+     */
+    static double error (const Matrix<double>& x, const Matrix<double>& y) {
+        CPPUNIT_ASSERT(x.rows() == y.rows() && x.columns() == y.columns());
+        double e = 0;
+        for (std::size_t r = 0; r < x.rows(); r++)
+            for (std::size_t c = 0; c < x.columns(); c++)
+                e = std::max(e, std::fabs(x[r][c] - y[r][c]));
+        return e;}
+
+    /**
+     * @return an r x c matrix of smooth, unstructured values.
+     */
+    static Matrix<double> sample (std::size_t r, std::size_t c) {
+        Matrix<double> x(r, c);
+        for (std::size_t i = 0; i < r; i++)
+            for (std::size_t j = 0; j < c; j++)
+                x[i][j] = std::sin(1.0 + i * 0.7 + j * j * 0.3) + std::cos(0.5 * i * j);
+        return x;}
+
+    // ---------
+    // test_eig1
+    // ---------
+
+    void test_eig1 () {
+        Matrix<double> x(3, 3, 0.0);
+        x[0][0] = x[1][1] = x[2][2] = 2;
+        x[0][1] = x[1][0] = x[1][2] = x[2][1] = 1;
+        Matrix<double> d = eig(x);
+        CPPUNIT_ASSERT(d.rows() == 3 && d.columns() == 1);
+        CPPUNIT_ASSERT(std::fabs(d[0][0] - (2 - std::sqrt(2.0))) < 1e-14);
+        CPPUNIT_ASSERT(std::fabs(d[1][0] - 2)                    < 1e-14);
+        CPPUNIT_ASSERT(std::fabs(d[2][0] - (2 + std::sqrt(2.0))) < 1e-14);}
+
+    // ---------
+    // test_eig2
+    // ---------
+
+    void test_eig2 () {
+        Matrix<double> y = sample(40, 40);
+        Matrix<double> x = y + transpose(y);
+        Matrix<double> v;
+        Matrix<double> d;
+        eig(x, v, d);
+        CPPUNIT_ASSERT(error(x * v, v * d) < 1e-12);
+        CPPUNIT_ASSERT(error(transpose(v) * v, eye< Matrix<double> >(40, 40)) < 1e-13);
+        Matrix<double> w = eig(x);
+        for (std::size_t i = 0; i < 40; i++) {
+            CPPUNIT_ASSERT(std::fabs(w[i][0] - d[i][i]) < 1e-12);
+            CPPUNIT_ASSERT(i == 0 || w[i - 1][0] <= w[i][0]);}}
+
+    // ---------
+    // test_eig3
+    // ---------
+
+    void test_eig3 () {
+        Matrix<double> v;
+        Matrix<double> d;
+        try {
+            eig(Matrix<double>(2, 3, 1.0), v, d);
+            CPPUNIT_ASSERT(false);
+        }
+        catch (DimensionException& e) {
+            CPPUNIT_ASSERT(v.rows() == 0 && d.rows() == 0);
+        }
+    }
+
+    // ---------
+    // test_eig4
+    // ---------
+
+    void test_eig4 () {
+        Matrix<double> x(3, 3, 1.0);
+        x[2][0] = std::numeric_limits<double>::infinity();
+        try {
+            eig(x);
+            CPPUNIT_ASSERT(false);
+        }
+        catch (ConvergenceException& e) {
+            CPPUNIT_ASSERT(e.err() == "No convergence: eig.\n");
+        }
+        x[2][0] = 1;
+        x[1][1] = std::numeric_limits<double>::quiet_NaN();
+        Matrix<double> v;
+        Matrix<double> d;
+        try {
+            eig(x, v, d);
+            CPPUNIT_ASSERT(false);
+        }
+        catch (ConvergenceException& e) {
+            CPPUNIT_ASSERT(v.rows() == 0 && d.rows() == 0);
+        }
+        // the upper triangle is not read
+        x[1][1] = 1;
+        x[0][2] = std::numeric_limits<double>::quiet_NaN();
+        d = eig(x);
+        CPPUNIT_ASSERT(std::fabs(d[2][0] - 3) < 1e-14);}
+
+
+    void test_eig_general1 () {
+        // the companion matrix of (t - 1)(t - 2)(t - 3) and a rotation by 90 degrees
+        Matrix<double> x(5, 5, 0.0);
+        x[0][0] = 6;
+        x[0][1] = -11;
+        x[0][2] = 6;
+        x[1][0] = 1;
+        x[2][1] = 1;
+        x[3][4] = -1;
+        x[4][3] = 1;
+        Matrix<double> wr;
+        Matrix<double> wi;
+        eig_general(x, wr, wi);
+        CPPUNIT_ASSERT(wr.rows() == 5 && wi.rows() == 5);
+        int real = 0;
+        int pair = 0;
+        for (std::size_t i = 0; i < 5; i++) {
+            if (wi[i][0] == 0) {
+                CPPUNIT_ASSERT(std::fabs(wr[i][0] - 1) < 1e-10 || std::fabs(wr[i][0] - 2) < 1e-10 || std::fabs(wr[i][0] - 3) < 1e-10);
+                real += int(wr[i][0] + 0.5);}
+            else {
+                CPPUNIT_ASSERT(std::fabs(wr[i][0]) < 1e-14 && std::fabs(std::fabs(wi[i][0]) - 1) < 1e-14);
+                ++pair;}}
+        CPPUNIT_ASSERT(real == 6 && pair == 2);}
+
+    // -----------------
+    // test_eig_general2
+    // -----------------
+
+    void test_eig_general2 () {
+        Matrix<double> x = sample(6, 6);
+        x[3][2] = std::numeric_limits<double>::quiet_NaN();
+        Matrix<double> wr;
+        Matrix<double> wi;
+        try {
+            eig_general(x, wr, wi);
+            CPPUNIT_ASSERT(false);
+        }
+        catch (ConvergenceException& e) {
+            CPPUNIT_ASSERT(e.err() == "No convergence: eig_general.\n");
+        }
+    }
+
+    // ---------
+    // test_svd1
+    // ---------
+
+    void test_svd1 () {
+        Matrix<double> x(3, 2, 0.0);
+        x[0][0] = 3;
+        x[1][1] = -4;
+        x[2][0] = 4;
+        Matrix<double> s = svd(x);
+        CPPUNIT_ASSERT(s.rows() == 2 && s.columns() == 1);
+        CPPUNIT_ASSERT(std::fabs(s[0][0] - 5) < 1e-14);
+        CPPUNIT_ASSERT(std::fabs(s[1][0] - 4) < 1e-14);
+        CPPUNIT_ASSERT(error(svd(transpose(x)), s) < 1e-14);}
+
+    // ---------
+    // test_svd2
+    // ---------
+
+    void test_svd2 () {
+        const std::size_t shape[2][2] = {{30, 20}, {20, 30}};
+        for (int t = 0; t < 2; t++) {
+            Matrix<double> x = sample(shape[t][0], shape[t][1]);
+            Matrix<double> u;
+            Matrix<double> s;
+            Matrix<double> v;
+            svd(x, u, s, v);
+            CPPUNIT_ASSERT(u.rows() == x.rows()    && u.columns() == 20);
+            CPPUNIT_ASSERT(v.rows() == x.columns() && v.columns() == 20);
+            CPPUNIT_ASSERT(error(u * s * transpose(v), x) < 1e-12);
+            CPPUNIT_ASSERT(error(transpose(u) * u, eye< Matrix<double> >(20, 20)) < 1e-13);
+            CPPUNIT_ASSERT(error(transpose(v) * v, eye< Matrix<double> >(20, 20)) < 1e-13);
+            for (std::size_t i = 1; i < 20; i++)
+                CPPUNIT_ASSERT(s[i - 1][i - 1] >= s[i][i] && s[i][i] >= 0);}}
+
+    // ---------
+    // test_svd3
+    // ---------
+
+    void test_svd3 () {
+        Matrix<double> x = sample(5, 4);
+        x[2][1] = std::numeric_limits<double>::infinity();
+        try {
+            svd(x);
+            CPPUNIT_ASSERT(false);
+        }
+        catch (ConvergenceException& e) {
+            CPPUNIT_ASSERT(true);
+        }
+        x[2][1] = std::numeric_limits<double>::quiet_NaN();
+        Matrix<double> u;
+        Matrix<double> s;
+        Matrix<double> v;
+        try {
+            svd(x, u, s, v);
+            CPPUNIT_ASSERT(false);
+        }
+        catch (ConvergenceException& e) {
+            CPPUNIT_ASSERT(u.rows() == 0);
+        }
+    }
+
+    // ---------
+    // test_svd4
+    // ---------
+
+    void test_svd4 () {
+        // more columns than a panel, with a zero column and a repeated one
+        const std::size_t shape[2][2] = {{100, 70}, {70, 100}};
+        for (int t = 0; t < 2; t++) {
+            Matrix<double> x = sample(shape[t][0], shape[t][1]);
+            for (std::size_t i = 0; i < x.rows(); i++) {
+                x[i][5]  = 0;
+                x[i][40] = x[i][3];}
+            Matrix<double> u;
+            Matrix<double> s;
+            Matrix<double> v;
+            svd(x, u, s, v);
+            CPPUNIT_ASSERT(error(u * s * transpose(v), x) < 1e-12);
+            CPPUNIT_ASSERT(error(transpose(u) * u, eye< Matrix<double> >(70, 70)) < 1e-13);
+            CPPUNIT_ASSERT(error(transpose(v) * v, eye< Matrix<double> >(70, 70)) < 1e-13);
+            CPPUNIT_ASSERT(error(svd(x), Matrix<double>(s * Matrix<double>(70, 1, 1.0))) < 1e-12);}}
+
+    // ----------
+    // test_svds1
+    // ----------
+
+    void test_svds1 () {
+        // a rank 3 matrix plus a little noise
+        Matrix<double> a = sample(80, 3);
+        Matrix<double> b = sample(3, 60);
+        Matrix<double> x = a * b + sample(80, 60) * 1e-6;
+        Matrix<double> u;
+        Matrix<double> s;
+        Matrix<double> v;
+        svds(x, 3, u, s, v);
+        CPPUNIT_ASSERT(u.rows() == 80 && u.columns() == 3);
+        CPPUNIT_ASSERT(s.rows() == 3  && s.columns() == 3);
+        CPPUNIT_ASSERT(v.rows() == 60 && v.columns() == 3);
+        Matrix<double> w = svd(x);
+        for (std::size_t i = 0; i < 3; i++)
+            CPPUNIT_ASSERT(std::fabs(s[i][i] - w[i][0]) < 1e-9 * w[0][0]);
+        CPPUNIT_ASSERT(error(u * s * transpose(v), x) < 1e-4);
+        CPPUNIT_ASSERT(error(transpose(u) * u, eye< Matrix<double> >(3, 3)) < 1e-13);}
+
+    // ----------
+    // test_svds2
+    // ----------
+
+    void test_svds2 () {
+        Matrix<double> u;
+        Matrix<double> s;
+        Matrix<double> v;
+        try {
+            svds(Matrix<double>(4, 3, 1.0), 4, u, s, v);
+            CPPUNIT_ASSERT(false);
+        }
+        catch (DimensionException& e) {
+            CPPUNIT_ASSERT(u.rows() == 0);
+        }
+    }
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestDecomposition);
+    CPPUNIT_TEST(test_eig1);
+    CPPUNIT_TEST(test_eig2);
+    CPPUNIT_TEST(test_eig3);
+    CPPUNIT_TEST(test_eig4);
+    CPPUNIT_TEST(test_eig_general1);
+    CPPUNIT_TEST(test_eig_general2);
+    CPPUNIT_TEST(test_svd1);
+    CPPUNIT_TEST(test_svd2);
+    CPPUNIT_TEST(test_svd3);
+    CPPUNIT_TEST(test_svd4);
+    CPPUNIT_TEST(test_svds1);
+    CPPUNIT_TEST(test_svds2);
+    CPPUNIT_TEST_SUITE_END();};
+
+// ----
+// main
+// ----
+
+int main () {
+    using namespace std;
+    ios_base::sync_with_stdio(false); // turn off synchronization with C I/O
+    cout << "TestDecomposition.c++" << endl;
+
+    CppUnit::TextTestRunner tr;
+    tr.addTest(TestDecomposition::suite());
+    tr.run();
+
+    cout << "Done." << endl;
+    return 0;}
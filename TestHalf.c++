@@ -0,0 +1,175 @@
+// ----------------------------
+// projects/matlab/TestHalf.c++
+// Copyright (C) 2012
+// Glenn P. Downing
+// ----------------------------
+
+/**
+ * To test the program:
+ *     g++ -ansi -pedantic -lcppunit -ldl -Wall TestHalf.c++ -o TestHalf.app
+ *     valgrind TestHalf.app >& TestHalf.out
+ */
+
+// --------
+// includes
+// --------
+
+#include <limits> // numeric_limits
+
+#include "cppunit/extensions/HelperMacros.h" // CPPUNIT_TEST, CPPUNIT_TEST_SUITE, CPPUNIT_TEST_SUITE_END
+#include "cppunit/TestFixture.h"             // TestFixture
+#include "cppunit/TextTestRunner.h"          // TestRunner
+
+#include "Matrix.h"
+#include "Matlab.h"
+#include "Half.h"
+
+// --------
+// TestHalf
+// --------
+
+struct TestHalf : CppUnit::TestFixture {
+    // ----------
+    // test_half1
+    // ----------
+
+    void test_half1 () {
+        CPPUNIT_ASSERT(half(1.0f).bits()     == 0x3c00);
+        CPPUNIT_ASSERT(half(-2.0f).bits()    == 0xc000);
+        CPPUNIT_ASSERT(half(65504.0f).bits() == 0x7bff);
+        CPPUNIT_ASSERT(half(1e6f).bits()     == 0x7c00);
+        CPPUNIT_ASSERT(half(std::numeric_limits<float>::quiet_NaN()).bits() == 0x7e00);
+        CPPUNIT_ASSERT(float(half::from_bits(0x0001)) == 5.9604644775390625e-8f);
+        CPPUNIT_ASSERT(float(half(0.333333f)) == 0.33325195f);}
+
+    // ----------
+    // test_half2
+    // ----------
+
+    void test_half2 () {
+        CPPUNIT_ASSERT(half(1.0f + 1.0f / 2048).bits() == 0x3c00);   // tie, rounds to even
+        CPPUNIT_ASSERT(half(1.0f + 3.0f / 2048).bits() == 0x3c02);   // tie, rounds to even
+        for (unsigned int b = 0; b < 0x7c00; ++b)
+            CPPUNIT_ASSERT(half(float(half::from_bits(static_cast<unsigned short>(b)))).bits() == b);}
+
+    // ----------
+    // test_half3
+    // ----------
+
+    void test_half3 () {
+        Matrix<half> x(2, 3, 1.5f);
+        Matrix<half> y(3, 2, 2.0f);
+        x *= y;
+        CPPUNIT_ASSERT(x.eq(Matrix<half>(2, 2, 9.0f)));
+        x += Matrix<half>(2, 2, 1.0f);
+        CPPUNIT_ASSERT(float(x[1][1]) == 10.0f);}
+
+    // --------------
+    // test_bfloat161
+    // --------------
+
+    void test_bfloat161 () {
+        CPPUNIT_ASSERT(bfloat16(1.0f).bits()  == 0x3f80);
+        CPPUNIT_ASSERT(bfloat16(-1.0f).bits() == 0xbf80);
+        CPPUNIT_ASSERT(bfloat16(1.0f + 1.0f / 256).bits() == 0x3f80); // tie, rounds to even
+        CPPUNIT_ASSERT(bfloat16(1.0f + 3.0f / 256).bits() == 0x3f82); // tie, rounds to even
+        CPPUNIT_ASSERT(float(bfloat16(3e38f)) > 2.9e38f);
+        CPPUNIT_ASSERT((bfloat16(std::numeric_limits<float>::quiet_NaN()).bits() & 0x7fc0) == 0x7fc0);}
+
+    // --------------
+    // test_bfloat162
+    // --------------
+
+    void test_bfloat162 () {
+        Matrix<bfloat16> x(1, 256, 1.0f);
+        Matrix<bfloat16> y(256, 1, 1.0f);
+        x *= y;
+        CPPUNIT_ASSERT(float(x[0][0]) == 256.0f);}
+
+    // ------------
+    // test_convert
+    // ------------
+
+    void test_convert () {
+        float f[19];
+        half  h[19];
+        for (int i = 0; i < 19; ++i)
+            f[i] = i * 0.5f - 4;
+        convert(f, 19, h);
+        float g[19];
+        convert(h, 19, g);
+        for (int i = 0; i < 19; ++i)
+            CPPUNIT_ASSERT(f[i] == g[i]);}
+
+    // ------------
+    // test_promote
+    // ------------
+
+    void test_promote () {
+        Matrix<half>     x(2, 2, 0.5f);
+        Matrix<bfloat16> y(2, 2, 0.25f);
+        Matrix<float>    z = x + y;
+        Matrix<double>   w = Matrix<double>(2, 2, 1) - x;
+        CPPUNIT_ASSERT(z.eq(Matrix<float>(2, 2, 0.75f)));
+        CPPUNIT_ASSERT(w.eq(Matrix<double>(2, 2, 0.5)));}
+
+    // -----------------
+    // test_elementwise
+    // -----------------
+
+    void test_elementwise () {
+        Matrix<half>     x(3, 19, 1.5f);
+        Matrix<half>     y(3, 19, 0.25f);
+        Matrix<bfloat16> z(3, 19, 2.0f);
+        x += y;
+        x *= half(2.0f);
+        z -= bfloat16(0.5f);
+        CPPUNIT_ASSERT(x.eq(Matrix<half>(3, 19, 3.5f)));
+        CPPUNIT_ASSERT(z.eq(Matrix<bfloat16>(3, 19, 1.5f)));
+        y[2][18] = 4.0f;
+        Matrix<bool> w = y < x;
+        CPPUNIT_ASSERT(w[0][0] && w[2][17] && !w[2][18]);
+        Matrix<half> v = x - 1;
+        CPPUNIT_ASSERT(v.eq(Matrix<half>(3, 19, 2.5f)));}
+
+    // ---------
+    // test_rand
+    // ---------
+
+    void test_rand () {
+        Matrix<half> x = rand< Matrix<half> >(3, 3);
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 3; ++c)
+                CPPUNIT_ASSERT(x[r][c] >= 0 && x[r][c] <= 1);}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestHalf);
+    CPPUNIT_TEST(test_half1);
+    CPPUNIT_TEST(test_half2);
+    CPPUNIT_TEST(test_half3);
+    CPPUNIT_TEST(test_bfloat161);
+    CPPUNIT_TEST(test_bfloat162);
+    CPPUNIT_TEST(test_convert);
+    CPPUNIT_TEST(test_promote);
+    CPPUNIT_TEST(test_elementwise);
+    CPPUNIT_TEST(test_rand);
+    CPPUNIT_TEST_SUITE_END();};
+
+// ----
+// main
+// ----
+
+int main () {
+    using namespace std;
+    ios_base::sync_with_stdio(false); // turn off synchronization with C I/O
+    cout << "TestHalf.c++" << endl;
+
+    CppUnit::TextTestRunner tr;
+    tr.addTest(TestHalf::suite());
+    tr.run();
+
+    cout << "Done." << endl;
+    return 0;}
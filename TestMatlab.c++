@@ -453,6 +453,22 @@ struct TestMatlab : CppUnit::TestFixture {
         }
         CPPUNIT_ASSERT(true);
     }
+
+    // ----------
+    // test_rand4
+    // ----------
+
+    void test_rand4 () {
+        Matrix<double> x = rand< Matrix<double> >(300, 300);
+        double sum = 0;
+        for (int r = 0; r < 300; r++)
+            for (int c = 0; c < 300; c++) {
+                CPPUNIT_ASSERT(x[r][c] >= 0 && x[r][c] < 1);
+                sum += x[r][c];}
+        CPPUNIT_ASSERT(sum > 0.49 * 90000 && sum < 0.51 * 90000);
+        CPPUNIT_ASSERT(x[0][0] != x[1][0] && x[0][1] != x[1][1]);
+        CPPUNIT_ASSERT(!x.eq(rand< Matrix<double> >(300, 300)));}
+
     // --------------
     // test_transpose1
     // --------------
@@ -509,13 +525,19 @@ struct TestMatlab : CppUnit::TestFixture {
     void test_tril1 () {
         Matrix<int> x(5, 4, 10);
         Matrix<int> y;
-        Matrix<int> w;
+        Matrix<int> w(5, 4, 10);
+        w[0][1] = 0;
+        w[0][2] = 0;
+        w[0][3] = 0;
+        w[1][2] = 0;
+        w[1][3] = 0;
+        w[2][3] = 0;
         try {
             y = tril(x);
-            CPPUNIT_ASSERT(false);
+            CPPUNIT_ASSERT(true);
         }
         catch (DimensionException& e) {
-            CPPUNIT_ASSERT(true);
+            CPPUNIT_ASSERT(false);
         }
         CPPUNIT_ASSERT(y.eq(w));
     }
@@ -578,6 +600,39 @@ struct TestMatlab : CppUnit::TestFixture {
         CPPUNIT_ASSERT(y.eq(w));
     }
 
+    // ---------
+    // test_tril5
+    // ---------
+
+    void test_tril5 () {
+        Matrix<int> x(3, 4, 10);
+        Matrix<int> w(3, 4, 0);
+        w[0][0] = w[0][1] = 10;
+        w[1][0] = w[1][1] = w[1][2] = 10;
+        w[2][0] = w[2][1] = w[2][2] = w[2][3] = 10;
+        CPPUNIT_ASSERT(tril(x, 1).eq(w));
+        CPPUNIT_ASSERT(tril(x, 3).eq(x));
+        CPPUNIT_ASSERT(tril(x, -3).eq(Matrix<int>(3, 4, 0)));
+        Matrix<int> v(3, 4, 0);
+        v[2][0] = 10;
+        CPPUNIT_ASSERT(tril(x, -2).eq(v));
+    }
+
+    // ---------
+    // test_tril6
+    // ---------
+
+    void test_tril6 () {
+        Matrix<int> x;
+        try {
+            tril(x);
+            CPPUNIT_ASSERT(false);
+        }
+        catch (DimensionException& e) {
+            CPPUNIT_ASSERT(true);
+        }
+    }
+
     // ---------
     // test_triu1
     // ---------
@@ -585,13 +640,23 @@ struct TestMatlab : CppUnit::TestFixture {
     void test_triu1 () {
         Matrix<int> x(5, 4, 10);
         Matrix<int> y;
-        Matrix<int> w;
+        Matrix<int> w(5, 4, 10);
+        w[1][0] = 0;
+        w[2][0] = 0;
+        w[2][1] = 0;
+        w[3][0] = 0;
+        w[3][1] = 0;
+        w[3][2] = 0;
+        w[4][0] = 0;
+        w[4][1] = 0;
+        w[4][2] = 0;
+        w[4][3] = 0;
         try {
             y = triu(x);
-            CPPUNIT_ASSERT(false);
+            CPPUNIT_ASSERT(true);
         }
         catch (DimensionException& e) {
-            CPPUNIT_ASSERT(true);
+            CPPUNIT_ASSERT(false);
         }
         CPPUNIT_ASSERT(y.eq(w));
     }
@@ -654,6 +719,40 @@ struct TestMatlab : CppUnit::TestFixture {
         CPPUNIT_ASSERT(y.eq(w));
     }
 
+    // ---------
+    // test_triu5
+    // ---------
+
+    void test_triu5 () {
+        Matrix<int> x(4, 3, 10);
+        Matrix<int> w(4, 3, 0);
+        w[0][0] = w[0][1] = w[0][2] = 10;
+        w[1][0] = w[1][1] = w[1][2] = 10;
+        w[2][1] = w[2][2] = 10;
+        w[3][2] = 10;
+        CPPUNIT_ASSERT(triu(x, -1).eq(w));
+        CPPUNIT_ASSERT(triu(x, -3).eq(x));
+        CPPUNIT_ASSERT(triu(x, 3).eq(Matrix<int>(4, 3, 0)));
+        Matrix<int> v(4, 3, 0);
+        v[0][2] = 10;
+        CPPUNIT_ASSERT(triu(x, 2).eq(v));
+    }
+
+    // ---------
+    // test_triu6
+    // ---------
+
+    void test_triu6 () {
+        Matrix<int> x;
+        try {
+            triu(x);
+            CPPUNIT_ASSERT(false);
+        }
+        catch (DimensionException& e) {
+            CPPUNIT_ASSERT(true);
+        }
+    }
+
     // ---------
     // test_zeros1
     // ---------
@@ -705,6 +804,78 @@ struct TestMatlab : CppUnit::TestFixture {
         CPPUNIT_ASSERT(x.eq(y));
     }
 
+    // ---------
+    // test_zeros4
+    // ---------
+
+    void test_zeros4 () {
+        Matrix<double> x = zeros< Matrix<double> >(300, 2000);
+        Matrix<double> y = zeros< Matrix<double> >(2000, 3);
+        CPPUNIT_ASSERT(x.eq(Matrix<double>(300, 2000, 0.0)));
+        x[299][1999] = 2;
+        y[1999][2]   = 3;
+        x *= y;
+        Matrix<double> w(300, 3, 0.0);
+        w[299][2] = 6;
+        CPPUNIT_ASSERT(x.eq(w));
+        CPPUNIT_ASSERT(Matrix<double>(2, 2, -0.0).eq(Matrix<double>(2, 2, 0.0)));
+    }
+
+    // -----------
+    // test_zeros5
+    // -----------
+
+    void test_zeros5 () {
+        Matrix<int> x = zeros< Matrix<int> >(1, 10);
+        x[0][5] = 7;
+        x[0].resize(3);
+        x[0].resize(10);
+        CPPUNIT_ASSERT(x[0][5] == 0);
+        Matrix<double> y(2, 8, 0.0);
+        y[1][4] = 4.5;
+        y[1].clear();
+        y[1].resize(8);
+        CPPUNIT_ASSERT(y[1][4] == 0);
+        y[1].reserve(20);
+        y[1].resize(16);
+        CPPUNIT_ASSERT(y[1][15] == 0);}
+
+    // ------------
+    // test_mtimes1
+    // ------------
+
+    void test_mtimes1 () {
+        ProductPolicy::cutoff() = 4;
+        Matrix<int> x(19, 23);
+        Matrix<int> y(23, 17);
+        for (int r = 0; r < 19; r++)
+            for (int c = 0; c < 23; c++)
+                x[r][c] = (r * 7 + c * 3) % 11 - 5;
+        for (int r = 0; r < 23; r++)
+            for (int c = 0; c < 17; c++)
+                y[r][c] = (r * 5 + c * 2) % 13 - 6;
+        Matrix<int> z = mtimes(x, y, strassen_product);
+        Matrix<int> w = mtimes(x, y, classical_product);
+        ProductPolicy::cutoff() = 512;
+        CPPUNIT_ASSERT(z.rows() == 19 && z.columns() == 17);
+        CPPUNIT_ASSERT(z.eq(w));}
+
+    // ------------
+    // test_mtimes2
+    // ------------
+
+    void test_mtimes2 () {
+        Matrix<int> x(3, 4, 1);
+        Matrix<int> y(3, 4, 1);
+        try {
+            mtimes(x, y, strassen_product);
+            CPPUNIT_ASSERT(false);
+        }
+        catch (DimensionException& e) {
+            CPPUNIT_ASSERT(true);
+        }
+    }
+
     // -----
     // suite
     // -----
@@ -732,6 +903,7 @@ struct TestMatlab : CppUnit::TestFixture {
     CPPUNIT_TEST(test_rand1);
     CPPUNIT_TEST(test_rand2);
     CPPUNIT_TEST(test_rand3);
+    CPPUNIT_TEST(test_rand4);
     CPPUNIT_TEST(test_transpose1);
     CPPUNIT_TEST(test_transpose2);
     CPPUNIT_TEST(test_transpose3);
@@ -739,13 +911,21 @@ struct TestMatlab : CppUnit::TestFixture {
     CPPUNIT_TEST(test_tril2);
     CPPUNIT_TEST(test_tril3);
     CPPUNIT_TEST(test_tril4);
+    CPPUNIT_TEST(test_tril5);
+    CPPUNIT_TEST(test_tril6);
     CPPUNIT_TEST(test_triu1);
     CPPUNIT_TEST(test_triu2);
     CPPUNIT_TEST(test_triu3);
     CPPUNIT_TEST(test_triu4);
+    CPPUNIT_TEST(test_triu5);
+    CPPUNIT_TEST(test_triu6);
     CPPUNIT_TEST(test_zeros1);
     CPPUNIT_TEST(test_zeros2);
     CPPUNIT_TEST(test_zeros3);
+    CPPUNIT_TEST(test_zeros4);
+    CPPUNIT_TEST(test_zeros5);
+    CPPUNIT_TEST(test_mtimes1);
+    CPPUNIT_TEST(test_mtimes2);
     //CPPUNIT_TEST(test_linsolve1);
     //CPPUNIT_TEST(test_linsolve2);
     //CPPUNIT_TEST(test_linsolve3);
@@ -14,11 +14,38 @@
 // includes
 // --------
 
+#include <fstream> // ifstream
+
 #include "cppunit/extensions/HelperMacros.h" // CPPUNIT_TEST, CPPUNIT_TEST_SUITE, CPPUNIT_TEST_SUITE_END
 #include "cppunit/TestFixture.h"             // TestFixture
 #include "cppunit/TextTestRunner.h"          // TestRunner
 #define private public
 #include "Matrix.h"
+// -----
+// Flaky
+// -----
+
+/**
+ * An element type whose copies run out of memory after a budget of them.
+ */
+struct Flaky {
+    static int budget;
+
+    Flaky () {}
+
+    Flaky (const Flaky&) {
+        if (budget-- == 0)
+            throw std::bad_alloc();}};
+
+int Flaky::budget = -1;
+
+// ----------
+// AuditCheck
+// ----------
+
+struct AuditCheck : ThrowCheck {
+    static const bool audit = true;};
+
 // ----------
 // TestMatrix
 // ----------
@@ -674,6 +701,304 @@ struct TestMatrix : CppUnit::TestFixture {
         Matrix<int>::const_iterator e = x.end();
         CPPUNIT_ASSERT(b == e);}
 
+    // -----------
+    // test_shape1
+    // -----------
+
+    void test_shape1 () {
+        Matrix<int> x(2, 3, 1);
+        Matrix<int> y(3, 5, 1);
+        x *= y;
+        CPPUNIT_ASSERT(x.rows()    == 2);
+        CPPUNIT_ASSERT(x.columns() == 5);
+        CPPUNIT_ASSERT(x.valid());}
+
+    // -----------
+    // test_shape2
+    // -----------
+
+    void test_shape2 () {
+        Matrix<int> x;
+        x.push_back(std::vector<int>(4, 1));
+        x.push_back(std::vector<int>(4, 2));
+        CPPUNIT_ASSERT(x.rows()    == 2);
+        CPPUNIT_ASSERT(x.columns() == 4);
+        try {
+            x.push_back(std::vector<int>(3, 3));
+            CPPUNIT_ASSERT(false);
+        }
+        catch(DimensionException& e) {
+            CPPUNIT_ASSERT(x.rows() == 2);
+        }
+    }
+
+    // -----------
+    // test_shape3
+    // -----------
+
+    void test_shape3 () {
+        Matrix<Flaky> x(2, 2);
+        Matrix<Flaky> y(3, 3);
+        Flaky::budget = 4;
+        try {
+            x = y;
+            CPPUNIT_ASSERT(false);
+        }
+        catch(std::bad_alloc& e) {
+            CPPUNIT_ASSERT(x.rows()    == 0);
+            CPPUNIT_ASSERT(x.columns() == 0);
+            CPPUNIT_ASSERT(x.valid());
+        }
+        Flaky::budget = -1;
+        x = y;
+        CPPUNIT_ASSERT(x.rows() == 3);
+        CPPUNIT_ASSERT(x.valid());}
+
+    // -----------
+    // test_check1
+    // -----------
+
+    void test_check1 () {
+        Matrix<int> x(2, 3, 1);
+        Matrix<int> y(3, 2, 1);
+        try {
+            x += y;
+            CPPUNIT_ASSERT(false);
+        }
+        catch(DimensionException& e) {
+            CPPUNIT_ASSERT(e.err() == "Dimension not matched: operator += (2x3, 3x2).\n");
+        }
+        CPPUNIT_ASSERT(DimensionException().err() == "Dimension not matched.\n");}
+
+    // -----------
+    // test_check2
+    // -----------
+
+    void test_check2 () {
+        ErrorCodeCheck::clear();
+        Matrix<int, ErrorCodeCheck> x(2, 3, 1);
+        Matrix<int, ErrorCodeCheck> y(3, 2, 1);
+        Matrix<int, ErrorCodeCheck> w(2, 3, 1);
+        x += w;
+        CPPUNIT_ASSERT(!ErrorCodeCheck::failed());
+        x -= y;
+        CPPUNIT_ASSERT(ErrorCodeCheck::failed());
+        CPPUNIT_ASSERT(ErrorCodeCheck::error().err() == "Dimension not matched: operator -= (2x3, 3x2).\n");
+        CPPUNIT_ASSERT(x.eq(Matrix<int, ErrorCodeCheck>(2, 3, 2)));
+        CPPUNIT_ASSERT((x == y).size() == 0);
+        ErrorCodeCheck::clear();
+        CPPUNIT_ASSERT(!ErrorCodeCheck::failed());}
+
+    // -----------
+    // test_check3
+    // -----------
+
+    void test_check3 () {
+        Matrix<int, NoCheck> x(2, 2, 1);
+        Matrix<int, NoCheck> y(2, 2, 2);
+        Matrix<bool, NoCheck> z = x < y;
+        CPPUNIT_ASSERT(z[1][1]);
+        CPPUNIT_ASSERT(!NoCheck::enabled);}
+
+    // -----------
+    // test_check4
+    // -----------
+
+    void test_check4 () {
+        Matrix<int, AuditCheck> x(2, 3, 1);
+        Matrix<int, AuditCheck> y(2, 3, 1);
+        x += y;
+        x[1].push_back(4);
+        try {
+            x += y;
+            CPPUNIT_ASSERT(false);
+        }
+        catch(DimensionException& e) {
+            CPPUNIT_ASSERT(e.err() == "Dimension not matched: operator += (2x3).\n");
+        }
+        try {
+            x *= 2;
+            CPPUNIT_ASSERT(false);
+        }
+        catch(DimensionException& e) {
+            CPPUNIT_ASSERT(x[0][0] == 2);
+        }
+        CPPUNIT_ASSERT(!ThrowCheck::audit);}
+
+    // -------------
+    // test_promote1
+    // -------------
+
+    void test_promote1 () {
+        Matrix<int>    x(2, 2, 1);
+        Matrix<double> y(2, 2, 0.5);
+        Matrix<double> z = x + y;
+        Matrix<double> w = y - x;
+        CPPUNIT_ASSERT(z.eq(Matrix<double>(2, 2, 1.5)));
+        CPPUNIT_ASSERT(w.eq(Matrix<double>(2, 2, -0.5)));}
+
+    // -------------
+    // test_promote2
+    // -------------
+
+    void test_promote2 () {
+        Matrix<int>   x(2, 3, 2);
+        Matrix<float> y(3, 1, 0.25f);
+        Matrix<float> z = x * y;
+        CPPUNIT_ASSERT(z.rows() == 2 && z.columns() == 1);
+        CPPUNIT_ASSERT(z.eq(Matrix<float>(2, 1, 1.5f)));
+        try {
+            y * x;
+            CPPUNIT_ASSERT(false);
+        }
+        catch(DimensionException& e) {
+            CPPUNIT_ASSERT(true);
+        }
+    }
+
+    // -------------
+    // test_promote3
+    // -------------
+
+    void test_promote3 () {
+        Matrix<float> x(1, 3, 1);
+        Matrix<float> y(3, 1);
+        y[0][0] = 1e8f;
+        y[1][0] = 1;
+        y[2][0] = -1e8f;
+        x *= y;
+        CPPUNIT_ASSERT(x[0][0] == 1);}
+
+    // -------------
+    // test_promote4
+    // -------------
+
+    void test_promote4 () {
+        Matrix<short> x(2, 2, 200);
+        x *= x;
+        CPPUNIT_ASSERT(x[0][0] == short(80000));
+        Matrix<bool> y(2, 3, true);
+        Matrix<bool> z(3, 2, false);
+        z[1][1] = true;
+        y *= z;
+        CPPUNIT_ASSERT(y.rows() == 2 && y.columns() == 2);
+        CPPUNIT_ASSERT(!y[0][0] && y[1][1]);
+        Matrix<bool> w(Matrix<int>(2, 2, 5));
+        CPPUNIT_ASSERT(w.eq(Matrix<bool>(2, 2, true)));
+        CPPUNIT_ASSERT(Matrix<int>(w).eq(Matrix<int>(2, 2, 1)));
+#if __cplusplus >= 201103L
+        Matrix<long long> v(2, 2, 1);
+        v *= v;
+        CPPUNIT_ASSERT(v.eq(Matrix<long long>(2, 2, 2)));
+#endif
+        }
+
+    // -------------
+    // test_promote5
+    // -------------
+
+    void test_promote5 () {
+        Matrix<int>    x(2, 2, 3);
+        Matrix<double> y = x * 2.5;
+        CPPUNIT_ASSERT(y.eq(Matrix<double>(2, 2, 7.5)));
+        CPPUNIT_ASSERT((x + 0.5).eq(Matrix<double>(2, 2, 3.5)));
+        CPPUNIT_ASSERT((x - 0.5f).eq(Matrix<float>(2, 2, 2.5f)));
+        Matrix<int>    z = x * 2;
+        Matrix<double> w = y * 2;
+        CPPUNIT_ASSERT(z.eq(Matrix<int>(2, 2, 6)));
+        CPPUNIT_ASSERT(w.eq(Matrix<double>(2, 2, 15)));
+        CPPUNIT_ASSERT((Matrix<char>(1, 1, 2) + 1).eq(Matrix<int>(1, 1, 3)));}
+
+    // ----------
+    // test_numa1
+    // ----------
+
+    void test_numa1 () {
+        const std::size_t r = 64;
+        const std::size_t c = MATRIX_NUMA_THRESHOLD / sizeof(double) / r;   // rows of a few pages
+        NumaPolicy::placement() = numa_interleave;
+        Matrix<double> x(r, c, 1.5);
+        Matrix<double> y(r, c);
+        Matrix<double> w(2, 2, 1.0);
+        NumaPolicy::placement() = numa_first_touch;
+        Matrix<double> v(r, c, 1.5);
+        CPPUNIT_ASSERT(x[0].get_allocator().placement() == numa_interleave);
+        CPPUNIT_ASSERT(y[r - 1].get_allocator().placement() == numa_interleave);
+        CPPUNIT_ASSERT(w[0].get_allocator().placement() == numa_first_touch);
+#ifdef __linux__
+        // mapped rows start on pages of their own
+        const std::size_t page = sysconf(_SC_PAGESIZE);
+        CPPUNIT_ASSERT(reinterpret_cast<std::size_t>(&x[0][0]) % page == 0);
+        CPPUNIT_ASSERT(reinterpret_cast<std::size_t>(&y[r - 1][0]) % page == 0);
+#endif
+        CPPUNIT_ASSERT(y[1][c - 1] == 0);
+        y += x;
+        y *= 2.0;
+        Matrix<double> z = y;
+        CPPUNIT_ASSERT(z[0].get_allocator().placement() == numa_first_touch);
+        z -= x;
+        CPPUNIT_ASSERT(z[0][0] == 1.5 && z[r - 1][c - 1] == 1.5);
+        x = w;
+        CPPUNIT_ASSERT(x.eq(w));}
+
+    // ----------
+    // test_numa2
+    // ----------
+
+    void test_numa2 () {
+        const std::size_t c = MATRIX_NUMA_THRESHOLD / sizeof(int) / 3 + 1;
+        NumaPolicy::placement() = numa_bind;
+        NumaPolicy::node()      = 0;
+        Matrix<int> x(2, 3, 2);
+        Matrix<int> y(3, c, 1);
+        NumaPolicy::placement() = numa_first_touch;
+        CPPUNIT_ASSERT(y[2].get_allocator().placement() == numa_bind);
+        x *= y;
+        CPPUNIT_ASSERT(x.rows() == 2 && x.columns() == c);
+        CPPUNIT_ASSERT(x[0][0] == 6 && x[1][c - 1] == 6);
+        Matrix<int> z(x);
+        x = y;
+        CPPUNIT_ASSERT(x.rows() == 3 && x[2][c - 1] == 1 && z[1][c - 1] == 6);}
+
+    // ----------
+    // test_numa3
+    // ----------
+
+    /**
+     * @return the resident pages of this process.
+     */
+    static std::size_t resident () {
+        std::ifstream in("/proc/self/statm");
+        std::size_t size     = 0;
+        std::size_t resident = 0;
+        in >> size >> resident;
+        return resident;}
+
+    void test_numa3 () {
+#ifdef __linux__
+        // rows of exactly a page take one page each
+        const std::size_t page = sysconf(_SC_PAGESIZE);
+        const std::size_t r    = 2048;
+        const std::size_t c    = page / sizeof(double);
+        NumaPolicy::placement() = numa_interleave;
+        const std::size_t before = resident();
+        Matrix<double> x(r, c, 1.5);
+        const std::size_t after = resident();
+        CPPUNIT_ASSERT(after - before < r + r / 8);
+        CPPUNIT_ASSERT(x[r - 1][c - 1] == 1.5);
+
+        // a node that does not exist is refused, and counted
+        NumaPolicy::placement() = numa_bind;
+        NumaPolicy::node()      = 63;
+        const std::size_t refused = NumaPolicy::refused();
+        Matrix<double> y(r, c, 2.5);
+        NumaPolicy::placement() = numa_first_touch;
+        NumaPolicy::node()      = 0;
+        CPPUNIT_ASSERT(NumaPolicy::refused() - refused == r);
+        CPPUNIT_ASSERT(y[r - 1][c - 1] == 2.5);
+#endif
+        }
+
     // -----
     // suite
     // -----
@@ -722,6 +1047,21 @@ struct TestMatrix : CppUnit::TestFixture {
     CPPUNIT_TEST(test_greater_than_or_equal_to1);
     CPPUNIT_TEST(test_greater_than_or_equal_to2);
     CPPUNIT_TEST(test_greater_than_or_equal_to3);
+    CPPUNIT_TEST(test_shape1);
+    CPPUNIT_TEST(test_shape2);
+    CPPUNIT_TEST(test_shape3);
+    CPPUNIT_TEST(test_check1);
+    CPPUNIT_TEST(test_check2);
+    CPPUNIT_TEST(test_check3);
+    CPPUNIT_TEST(test_check4);
+    CPPUNIT_TEST(test_promote1);
+    CPPUNIT_TEST(test_promote2);
+    CPPUNIT_TEST(test_promote3);
+    CPPUNIT_TEST(test_promote4);
+    CPPUNIT_TEST(test_promote5);
+    CPPUNIT_TEST(test_numa1);
+    CPPUNIT_TEST(test_numa2);
+    CPPUNIT_TEST(test_numa3);
     CPPUNIT_TEST_SUITE_END();};
 
 // ----
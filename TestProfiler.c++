@@ -0,0 +1,157 @@
+// --------------------------------
+// projects/matlab/TestProfiler.c++
+// Copyright (C) 2012
+// Glenn P. Downing
+// --------------------------------
+
+/**
+ * To test the program:
+ *     g++ -std=c++11 -pedantic -lcppunit -ldl -Wall TestProfiler.c++ -o TestProfiler.app
+ *     valgrind TestProfiler.app >& TestProfiler.out
+ */
+
+// --------
+// includes
+// --------
+
+#include <sstream> // ostringstream
+
+#include "cppunit/extensions/HelperMacros.h" // CPPUNIT_TEST, CPPUNIT_TEST_SUITE, CPPUNIT_TEST_SUITE_END
+#include "cppunit/TestFixture.h"             // TestFixture
+#include "cppunit/TextTestRunner.h"          // TestRunner
+
+#define MATRIX_PROFILE
+#include "Matrix.h"
+#include "Matlab.h"
+
+// ------------
+// TestProfiler
+// ------------
+
+struct TestProfiler : CppUnit::TestFixture {
+    void setUp () {
+        Profiler::instance().reset();}
+
+    // ------------
+    // test_record1
+    // ------------
+
+    void test_record1 () {
+        Matrix<int> x(2, 3, 1);
+        Matrix<int> y(3, 4, 1);
+        x *= y;
+        Profiler::Record r = Profiler::instance().get("operator *=");
+        CPPUNIT_ASSERT(r.calls    == 1);
+        CPPUNIT_ASSERT(r.elements == 24);
+        CPPUNIT_ASSERT(r.copies   == 0);
+        CPPUNIT_ASSERT(r.bytes    >= 12 * sizeof(int));}
+
+    // ------------
+    // test_record2
+    // ------------
+
+    void test_record2 () {
+        Matrix<int> x(2, 2, 1);
+        Matrix<int> y(2, 3, 1);
+        Matrix<int> z = horzcat(x, y);
+        Profiler::Record r = Profiler::instance().get("horzcat");
+        CPPUNIT_ASSERT(r.calls    == 1);
+        CPPUNIT_ASSERT(r.elements == 10);
+        CPPUNIT_ASSERT(r.copies   == 0);
+        CPPUNIT_ASSERT(z[1].size() == 5);}
+
+    // ------------
+    // test_record3
+    // ------------
+
+    void test_record3 () {
+        Matrix<int> x(2, 2, 1);
+        x += 2;
+        x += 3;
+        CPPUNIT_ASSERT(Profiler::instance().get("operator += (scalar)").calls == 2);
+        CPPUNIT_ASSERT(Profiler::instance().get("operator -= (scalar)").calls == 0);
+        Profiler::instance().reset();
+        CPPUNIT_ASSERT(Profiler::instance().get("operator += (scalar)").calls == 0);}
+
+    // ------------
+    // test_record4
+    // ------------
+
+    void test_record4 () {
+        Matrix<int> x(2, 2, 1);
+        Matrix<int> y(3, 2, 1);
+        try {
+            x += y;
+            CPPUNIT_ASSERT(false);}
+        catch (DimensionException& e) {
+            CPPUNIT_ASSERT(Profiler::instance().get("operator +=").calls == 0);}}
+
+    // ------------
+    // test_record5
+    // ------------
+
+    void test_record5 () {
+        Matrix<int> x(2, 2, 1);
+        Matrix<int> y(x);
+        x = x;
+        Profiler::Record r = Profiler::instance().get("(outside operations)");
+        CPPUNIT_ASSERT(r.calls  == 0);
+        CPPUNIT_ASSERT(r.copies == 1);
+        CPPUNIT_ASSERT(r.bytes  == 8 * sizeof(int));
+        std::ostringstream out;
+        Profiler::instance().trace(out);
+        CPPUNIT_ASSERT(out.str().find("(outside operations)") == std::string::npos);}
+
+    // -----------
+    // test_report
+    // -----------
+
+    void test_report () {
+        Matrix<int> x(2, 2, 1);
+        x = x + x;
+        std::ostringstream out;
+        Profiler::instance().report(out);
+        CPPUNIT_ASSERT(out.str().find("operator +=")          != std::string::npos);
+        CPPUNIT_ASSERT(out.str().find("(outside operations)") != std::string::npos);}
+
+    // ----------
+    // test_trace
+    // ----------
+
+    void test_trace () {
+        Matrix<int> x(2, 3, 1);
+        transpose(x);
+        std::ostringstream out;
+        Profiler::instance().trace(out);
+        CPPUNIT_ASSERT(out.str().find("{\"traceEvents\":[") == 0);
+        CPPUNIT_ASSERT(out.str().find("\"name\":\"transpose\"") != std::string::npos);}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestProfiler);
+    CPPUNIT_TEST(test_record1);
+    CPPUNIT_TEST(test_record2);
+    CPPUNIT_TEST(test_record3);
+    CPPUNIT_TEST(test_record4);
+    CPPUNIT_TEST(test_record5);
+    CPPUNIT_TEST(test_report);
+    CPPUNIT_TEST(test_trace);
+    CPPUNIT_TEST_SUITE_END();};
+
+// ----
+// main
+// ----
+
+int main () {
+    using namespace std;
+    ios_base::sync_with_stdio(false); // turn off synchronization with C I/O
+    cout << "TestProfiler.c++" << endl;
+
+    CppUnit::TextTestRunner tr;
+    tr.addTest(TestProfiler::suite());
+    tr.run();
+
+    cout << "Done." << endl;
+    return 0;}
@@ -0,0 +1,141 @@
+// --------------------------------
+// projects/matlab/TestStrassen.c++
+// Copyright (C) 2012
+// Glenn P. Downing
+// --------------------------------
+
+/**
+ * To test the program:
+ *     g++ -ansi -pedantic -fopenmp -lcppunit -ldl -Wall TestStrassen.c++ -o TestStrassen.app
+ *     valgrind TestStrassen.app >& TestStrassen.out
+ */
+
+// --------
+// includes
+// --------
+
+#include <cmath> // fabs
+
+#include "cppunit/extensions/HelperMacros.h" // CPPUNIT_TEST, CPPUNIT_TEST_SUITE, CPPUNIT_TEST_SUITE_END
+#include "cppunit/TestFixture.h"             // TestFixture
+#include "cppunit/TextTestRunner.h"          // TestRunner
+
+#include "Matrix.h"
+#include "Strassen.h"
+
+// ------------
+// TestStrassen
+// ------------
+
+struct TestStrassen : CppUnit::TestFixture {
+    std::size_t parallel;
+
+    void setUp () {
+        parallel = ProductPolicy::parallel();}
+
+    void tearDown () {
+        ProductPolicy::algorithm() = classical_product;
+        ProductPolicy::threshold() = 4096;
+        ProductPolicy::cutoff()    = 512;
+        ProductPolicy::parallel()  = parallel;}
+
+    // ------------
+    // test_levels1
+    // ------------
+
+    void test_levels1 () {
+        CPPUNIT_ASSERT(strassen_levels(4096, 4096, 4096, 512) == 3);
+        CPPUNIT_ASSERT(strassen_levels(5000, 6000, 7000, 256) == 4);
+        CPPUNIT_ASSERT(strassen_levels(1000, 1000,   10, 256) == 0);
+        CPPUNIT_ASSERT(strassen_round(5000, 4) == 5008);}
+
+    // ---------------
+    // test_workspace1
+    // ---------------
+
+    void test_workspace1 () {
+        CPPUNIT_ASSERT(strassen_workspace(8, 8, 8, 0, 0) == 0);
+        CPPUNIT_ASSERT(strassen_workspace(8, 8, 8, 1, 0) == 3 * 16);
+        CPPUNIT_ASSERT(strassen_workspace(8, 8, 8, 1, 1) == 7 * 3 * 16);
+        CPPUNIT_ASSERT(strassen_workspace(8, 8, 8, 2, 1) == 7 * (3 * 16 + 3 * 4));}
+
+    // --------------
+    // test_strassen1
+    // --------------
+
+    void test_strassen1 () {
+        const int a[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+        const int b[16] = {1, 0, 0, 0, 0, 2, 0, 0, 0, 0, 3, 0, 0, 0, 0, 4};
+        int c[16];
+        std::vector<int> w(strassen_workspace(4, 4, 4, 2, 2));
+        CPPUNIT_ASSERT(w.size() == 7 * (3 * 4 + 7 * 3 * 1));
+        strassen_run(a, 4, b, 4, c, 4, 4, 4, 4, 2, 2, &w[0]);
+        for (int i = 0; i < 16; i++)
+            CPPUNIT_ASSERT(c[i] == a[i] * (i % 4 + 1));}
+
+    // --------------
+    // test_strassen2
+    // --------------
+
+    void test_strassen2 () {
+        ProductPolicy::algorithm() = strassen_product;
+        ProductPolicy::threshold() = 16;
+        ProductPolicy::cutoff()    = 8;
+        Matrix<double> x(45, 33);
+        Matrix<double> y(33, 50);
+        for (int r = 0; r < 45; r++)
+            for (int c = 0; c < 33; c++)
+                x[r][c] = std::sin(r + 2.0 * c);
+        for (int r = 0; r < 33; r++)
+            for (int c = 0; c < 50; c++)
+                y[r][c] = std::cos(3.0 * r - c);
+        Matrix<double> z = x;
+        z *= y;
+        Matrix<double> w = x;
+        w.multiply(y, classical_product);
+        CPPUNIT_ASSERT(z.rows() == 45 && z.columns() == 50);
+        for (int r = 0; r < 45; r++)
+            for (int c = 0; c < 50; c++)
+                CPPUNIT_ASSERT(std::fabs(z[r][c] - w[r][c]) < 1e-12);}
+
+    // --------------
+    // test_strassen3
+    // --------------
+
+    void test_strassen3 () {
+        ProductPolicy::algorithm() = strassen_product;
+        ProductPolicy::threshold() = 32;
+        ProductPolicy::cutoff()    = 8;
+        ProductPolicy::parallel()  = 0;
+        Matrix<long> x(32, 32, 3);
+        Matrix<long> y(32, 32, 2);
+        x *= y;
+        CPPUNIT_ASSERT(x.eq(Matrix<long>(32, 32, 192)));}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestStrassen);
+    CPPUNIT_TEST(test_levels1);
+    CPPUNIT_TEST(test_workspace1);
+    CPPUNIT_TEST(test_strassen1);
+    CPPUNIT_TEST(test_strassen2);
+    CPPUNIT_TEST(test_strassen3);
+    CPPUNIT_TEST_SUITE_END();};
+
+// ----
+// main
+// ----
+
+int main () {
+    using namespace std;
+    ios_base::sync_with_stdio(false); // turn off synchronization with C I/O
+    cout << "TestStrassen.c++" << endl;
+
+    CppUnit::TextTestRunner tr;
+    tr.addTest(TestStrassen::suite());
+    tr.run();
+
+    cout << "Done." << endl;
+    return 0;}